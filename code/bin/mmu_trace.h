@@ -0,0 +1,37 @@
+/// Format of the memory reference traces written by the MMU.
+///
+/// A trace is a header followed by records.  Every record stands for one or
+/// more consecutive accesses of the same kind to the same page; runs of
+/// accesses to one page, such as those of straight-line code, take a single
+/// record.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_BIN_MMUTRACE__H
+#define NACHOS_BIN_MMUTRACE__H
+
+
+#include <stdint.h>
+
+
+#define MMU_TRACE_MAGIC  0x4E545243  // Magic number denoting a trace file.
+
+#define MMU_TRACE_WRITE      0x8000  // Flag for writes in `count`.
+#define MMU_TRACE_MAX_COUNT  0x7FFF  // Largest run in a single record.
+
+typedef struct mmuTraceHeader {
+    uint32_t magic;     // Should be `MMU_TRACE_MAGIC`.
+    uint32_t pageSize;  // Size of the pages, in bytes.
+} mmuTraceHeader;
+
+typedef struct mmuTraceRecord {
+    uint32_t vpn;    // Virtual page accessed.
+    uint16_t asid;   // Address space the page belongs to.
+    uint16_t count;  // Number of accesses, plus `MMU_TRACE_WRITE` if they
+                     // are writes.
+} mmuTraceRecord;
+
+
+#endif
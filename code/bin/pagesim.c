@@ -0,0 +1,493 @@
+/// Program that replays a memory reference trace written by the MMU (see
+/// `mmu_trace.h`) against several page replacement policies, and prints
+/// their fault rates for a range of memory sizes.
+///
+/// Pages of every address space compete for the same frames, as they do in
+/// the kernel.  FIFO, clock and Belady's optimal policy are simulated once
+/// per number of frames; LRU is computed for every number of frames at once
+/// from stack distances.  The working set policy does not take a number of
+/// frames but a window, so it gets a table of its own with the mean size
+/// of the working set for every window.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#define _POSIX_C_SOURCE 200809L  // For `getopt`.
+
+#include "mmu_trace.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/// The trace, with every page renamed to a small integer.
+typedef struct trace {
+    unsigned length;    // Number of records.
+    unsigned *page;     // Page of every record.
+    unsigned *count;    // Accesses in every record.
+    unsigned numPages;  // Number of different pages.
+    unsigned long numAccesses;
+    unsigned long numWrites;
+} trace;
+
+static void *
+Allocate(size_t n, size_t size)
+{
+    void *p = calloc(n == 0 ? 1 : n, size);
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory.\n");
+        exit(1);
+    }
+    return p;
+}
+
+/// Open addressing table from (address space, virtual page) to the dense
+/// page numbers used by the simulations.
+typedef struct pageNames {
+    uint64_t *keys;
+    unsigned *names;
+    unsigned size;
+    unsigned used;
+} pageNames;
+
+static unsigned
+NamePage(pageNames *t, uint64_t key)
+{
+    if (2 * (t->used + 1) > t->size) {
+        pageNames bigger = {
+            Allocate(2 * t->size, sizeof (uint64_t)),
+            Allocate(2 * t->size, sizeof (unsigned)),
+            2 * t->size, 0
+        };
+        for (unsigned i = 0; i < t->size; i++) {
+            if (t->names[i] != 0) {
+                unsigned s = (unsigned) (t->keys[i] * 0x9E3779B97F4A7C15u
+                                         >> 32) % bigger.size;
+                while (bigger.names[s] != 0) {
+                    s = (s + 1) % bigger.size;
+                }
+                bigger.keys[s] = t->keys[i];
+                bigger.names[s] = t->names[i];
+            }
+        }
+        bigger.used = t->used;
+        free(t->keys);
+        free(t->names);
+        *t = bigger;
+    }
+
+    unsigned s = (unsigned) (key * 0x9E3779B97F4A7C15u >> 32) % t->size;
+    for (; t->names[s] != 0; s = (s + 1) % t->size) {
+        if (t->keys[s] == key) {
+            return t->names[s] - 1;
+        }
+    }
+    t->keys[s] = key;
+    t->names[s] = ++t->used;
+    return t->used - 1;
+}
+
+static bool
+ReadTrace(const char *path, trace *t)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+
+    mmuTraceHeader h;
+    if (fread(&h, sizeof h, 1, f) != 1 || h.magic != MMU_TRACE_MAGIC) {
+        fprintf(stderr, "%s: not a memory trace\n", path);
+        fclose(f);
+        return false;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long bytes = ftell(f) - (long) sizeof h;
+    fseek(f, sizeof h, SEEK_SET);
+    unsigned capacity = bytes / sizeof (mmuTraceRecord);
+
+    memset(t, 0, sizeof *t);
+    t->page = Allocate(capacity, sizeof (unsigned));
+    t->count = Allocate(capacity, sizeof (unsigned));
+    pageNames names = {
+        Allocate(1024, sizeof (uint64_t)), Allocate(1024, sizeof (unsigned)),
+        1024, 0
+    };
+
+    mmuTraceRecord r;
+    while (t->length < capacity && fread(&r, sizeof r, 1, f) == 1) {
+        unsigned count = r.count & MMU_TRACE_MAX_COUNT;
+        t->page[t->length] = NamePage(&names,
+                                      (uint64_t) r.asid << 32 | r.vpn);
+        t->count[t->length] = count;
+        t->numAccesses += count;
+        if (r.count & MMU_TRACE_WRITE) {
+            t->numWrites += count;
+        }
+        t->length++;
+    }
+    t->numPages = names.used;
+
+    free(names.keys);
+    free(names.names);
+    fclose(f);
+    return true;
+}
+
+static unsigned long
+SimulateFifo(const trace *t, unsigned frames)
+{
+    bool *resident = Allocate(t->numPages, sizeof (bool));
+    unsigned *queue = Allocate(frames, sizeof (unsigned));
+    unsigned used = 0, next = 0;
+    unsigned long faults = 0;
+
+    for (unsigned i = 0; i < t->length; i++) {
+        unsigned p = t->page[i];
+        if (resident[p]) {
+            continue;
+        }
+        faults++;
+        if (used < frames) {
+            queue[used++] = p;
+        } else {
+            resident[queue[next]] = false;
+            queue[next] = p;
+            next = (next + 1) % frames;
+        }
+        resident[p] = true;
+    }
+
+    free(resident);
+    free(queue);
+    return faults;
+}
+
+static unsigned long
+SimulateClock(const trace *t, unsigned frames)
+{
+    bool *resident = Allocate(t->numPages, sizeof (bool));
+    bool *referenced = Allocate(t->numPages, sizeof (bool));
+    unsigned *ring = Allocate(frames, sizeof (unsigned));
+    unsigned used = 0, hand = 0;
+    unsigned long faults = 0;
+
+    for (unsigned i = 0; i < t->length; i++) {
+        unsigned p = t->page[i];
+        if (resident[p]) {
+            referenced[p] = true;
+            continue;
+        }
+        faults++;
+        if (used < frames) {
+            ring[used++] = p;
+        } else {
+            while (referenced[ring[hand]]) {
+                referenced[ring[hand]] = false;
+                hand = (hand + 1) % frames;
+            }
+            resident[ring[hand]] = false;
+            ring[hand] = p;
+            hand = (hand + 1) % frames;
+        }
+        resident[p] = true;
+        referenced[p] = true;
+    }
+
+    free(resident);
+    free(referenced);
+    free(ring);
+    return faults;
+}
+
+/// Fill `faults[f]`, for `f` from 1 to `maxFrames`, with the faults of LRU
+/// with `f` frames.
+///
+/// A reference faults under LRU with `f` frames if and only if more than
+/// `f - 1` other pages were referenced since the previous reference to the
+/// same page (its stack distance).  Distances are counted with a Fenwick
+/// tree over the records, holding a one at the last reference to every
+/// page.
+static void
+SimulateLru(const trace *t, unsigned maxFrames, unsigned long *faults)
+{
+    unsigned n = t->length;
+    unsigned *tree = Allocate(n + 1, sizeof (unsigned));
+    unsigned *last = Allocate(t->numPages, sizeof (unsigned));
+    unsigned long *histogram = Allocate(maxFrames + 2,
+                                        sizeof (unsigned long));
+
+    for (unsigned i = 0; i < n; i++) {
+        unsigned p = t->page[i];
+        unsigned distance;
+        if (last[p] == 0) {
+            distance = maxFrames + 1;  // First reference: always a fault.
+        } else {
+            // Distinct pages referenced in the records after `last[p]`.
+            unsigned sum = 0;
+            for (unsigned k = i; k > 0; k -= k & -k) {
+                sum += tree[k];
+            }
+            for (unsigned k = last[p]; k > 0; k -= k & -k) {
+                sum -= tree[k];
+            }
+            distance = sum + 1;
+            if (distance > maxFrames + 1) {
+                distance = maxFrames + 1;
+            }
+            for (unsigned k = last[p]; k <= n; k += k & -k) {
+                tree[k]--;
+            }
+        }
+        histogram[distance]++;
+        last[p] = i + 1;
+        for (unsigned k = i + 1; k <= n; k += k & -k) {
+            tree[k]++;
+        }
+    }
+
+    // With `f` frames, every distance larger than `f` faults.
+    unsigned long sum = histogram[maxFrames + 1];
+    for (unsigned f = maxFrames; f >= 1; f--) {
+        faults[f] = sum;
+        sum += histogram[f];
+    }
+
+    free(tree);
+    free(last);
+    free(histogram);
+}
+
+/// Max-heap of resident pages keyed by their next reference.
+typedef struct heapEntry {
+    unsigned nextUse;
+    unsigned page;
+} heapEntry;
+
+static void
+HeapPush(heapEntry *heap, unsigned *size, heapEntry e)
+{
+    unsigned i = (*size)++;
+    while (i > 0 && heap[(i - 1) / 2].nextUse < e.nextUse) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = e;
+}
+
+static heapEntry
+HeapPop(heapEntry *heap, unsigned *size)
+{
+    heapEntry top = heap[0];
+    heapEntry e = heap[--*size];
+    unsigned i = 0;
+    for (;;) {
+        unsigned c = 2 * i + 1;
+        if (c >= *size) {
+            break;
+        }
+        if (c + 1 < *size && heap[c + 1].nextUse > heap[c].nextUse) {
+            c++;
+        }
+        if (heap[c].nextUse <= e.nextUse) {
+            break;
+        }
+        heap[i] = heap[c];
+        i = c;
+    }
+    heap[i] = e;
+    return top;
+}
+
+/// Belady's policy: evict the page whose next reference is farthest away.
+///
+/// `nextUse[i]` is the record of the next reference to the page of record
+/// `i`, or the length of the trace if there is none.  Heap entries made
+/// stale by later references are skipped when popped.
+static unsigned long
+SimulateOpt(const trace *t, const unsigned *nextUse, unsigned frames)
+{
+    bool *resident = Allocate(t->numPages, sizeof (bool));
+    unsigned *current = Allocate(t->numPages, sizeof (unsigned));
+    heapEntry *heap = Allocate(t->length, sizeof (heapEntry));
+    unsigned heapSize = 0, used = 0;
+    unsigned long faults = 0;
+
+    for (unsigned i = 0; i < t->length; i++) {
+        unsigned p = t->page[i];
+        if (!resident[p]) {
+            faults++;
+            if (used < frames) {
+                used++;
+            } else {
+                for (;;) {
+                    heapEntry e = HeapPop(heap, &heapSize);
+                    if (resident[e.page] && current[e.page] == e.nextUse) {
+                        resident[e.page] = false;
+                        break;
+                    }
+                }
+            }
+            resident[p] = true;
+        }
+        current[p] = nextUse[i];
+        heapEntry e = { nextUse[i], p };
+        HeapPush(heap, &heapSize, e);
+    }
+
+    free(resident);
+    free(current);
+    free(heap);
+    return faults;
+}
+
+/// Working set policy with a window of `window` accesses: a page stays in
+/// memory as long as it was accessed within the window.
+///
+/// Returns the faults and leaves in `meanSize` the mean number of pages in
+/// memory.
+static unsigned long
+SimulateWorkingSet(const trace *t, unsigned long window, double *meanSize)
+{
+    unsigned long *lastAccess = Allocate(t->numPages,
+                                         sizeof (unsigned long));
+    bool *seen = Allocate(t->numPages, sizeof (bool));
+    unsigned long faults = 0, now = 0;
+    double residency = 0;
+
+    for (unsigned i = 0; i < t->length; i++) {
+        unsigned p = t->page[i];
+        if (!seen[p]) {
+            faults++;
+            seen[p] = true;
+        } else {
+            unsigned long gap = now - lastAccess[p];
+            if (gap > window) {
+                faults++;
+                gap = window;
+            }
+            residency += gap;
+        }
+        // The accesses of a record come one after the other.
+        now += t->count[i];
+        lastAccess[p] = now;
+        residency += t->count[i] - 1;
+    }
+    for (unsigned p = 0; p < t->numPages; p++) {
+        if (seen[p]) {
+            unsigned long gap = now - lastAccess[p];
+            residency += gap < window ? gap : window;
+        }
+    }
+    *meanSize = now > 0 ? residency / now : 0;
+
+    free(lastAccess);
+    free(seen);
+    return faults;
+}
+
+static void
+Usage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [-f <min frames>] [-F <max frames>] [-s <step>]\n"
+            "           [-w <min window>] [-W <max window>] <trace file>\n"
+            "\n"
+            "Frames go from min to max by step; windows double from min to"
+            " max.\n", program);
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned minFrames = 4, maxFrames = 0, step = 0;
+    unsigned long minWindow = 64, maxWindow = 0;
+
+    int c;
+    while ((c = getopt(argc, argv, "f:F:s:w:W:")) != -1) {
+        switch (c) {
+            case 'f': minFrames = atoi(optarg); break;
+            case 'F': maxFrames = atoi(optarg); break;
+            case 's': step = atoi(optarg); break;
+            case 'w': minWindow = atol(optarg); break;
+            case 'W': maxWindow = atol(optarg); break;
+            default:
+                Usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1 || minFrames == 0 || minWindow == 0) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    trace t;
+    if (!ReadTrace(argv[optind], &t)) {
+        return 1;
+    }
+    if (t.length == 0) {
+        fprintf(stderr, "%s: empty trace\n", argv[optind]);
+        return 1;
+    }
+
+    // By default, sweep up to the point where everything fits.
+    if (maxFrames == 0) {
+        maxFrames = t.numPages > minFrames ? t.numPages : minFrames;
+    }
+    if (step == 0) {
+        step = (maxFrames - minFrames) / 16 > 0
+               ? (maxFrames - minFrames) / 16 : 1;
+    }
+    if (maxWindow == 0) {
+        maxWindow = t.numAccesses;
+    }
+
+    printf("Trace: %lu accesses (%lu writes) in %u records, %u pages\n\n",
+           t.numAccesses, t.numWrites, t.length, t.numPages);
+
+    unsigned *nextUse = Allocate(t.length, sizeof (unsigned));
+    unsigned *following = Allocate(t.numPages, sizeof (unsigned));
+    for (unsigned p = 0; p < t.numPages; p++) {
+        following[p] = t.length;
+    }
+    for (unsigned i = t.length; i-- > 0;) {
+        nextUse[i] = following[t.page[i]];
+        following[t.page[i]] = i;
+    }
+    free(following);
+
+    unsigned long *lru = Allocate(maxFrames + 1, sizeof (unsigned long));
+    SimulateLru(&t, maxFrames, lru);
+
+    // Rates are faults per thousand accesses.
+    double scale = 1000.0 / t.numAccesses;
+    printf("Faults per 1000 accesses:\n");
+    printf("%8s %10s %10s %10s %10s\n", "frames", "FIFO", "clock", "LRU",
+           "OPT");
+    for (unsigned f = minFrames; f <= maxFrames; f += step) {
+        printf("%8u %10.3f %10.3f %10.3f %10.3f\n", f,
+               SimulateFifo(&t, f) * scale, SimulateClock(&t, f) * scale,
+               lru[f] * scale, SimulateOpt(&t, nextUse, f) * scale);
+    }
+
+    printf("\nWorking set:\n");
+    printf("%12s %10s %10s\n", "window", "mean size", "faults");
+    for (unsigned long w = minWindow; w <= maxWindow; w *= 2) {
+        double meanSize;
+        unsigned long faults = SimulateWorkingSet(&t, w, &meanSize);
+        printf("%12lu %10.1f %10.3f\n", w, meanSize, faults * scale);
+    }
+
+    free(lru);
+    free(nextUse);
+    free(t.page);
+    free(t.count);
+    return 0;
+}
@@ -17,6 +17,7 @@
 
 #include "raw_directory.hh"
 #include "open_file.hh"
+#include "lib/slab.hh"
 
 
 /// The following class defines a UNIX-like “directory”.  Each entry in the
@@ -30,6 +31,7 @@
 /// from/to disk.
 class Directory {
 public:
+    SLAB_ALLOCATED(Directory)
 
     /// Initialize an empty directory with space for `size` files.
     Directory(unsigned size);
@@ -15,6 +15,7 @@
 
 #include "raw_file_header.hh"
 #include "lib/bitmap.hh"
+#include "lib/slab.hh"
 
 
 /// The following class defines the Nachos "file header" (in UNIX terms, the
@@ -33,6 +34,7 @@
 /// reading it from disk.
 class FileHeader {
 public:
+    SLAB_ALLOCATED(FileHeader)
 
     /// Initialize a file header, including allocating space on disk for the
     /// file data.
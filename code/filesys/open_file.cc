@@ -128,7 +128,7 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
     numSectors = 1 + lastSector - firstSector;
 
     // Read in all the full and partial sectors that we need.
-    buf = new char [numSectors * SECTOR_SIZE];
+    buf = AllocBuffer(numSectors * SECTOR_SIZE);
     for (unsigned i = firstSector; i <= lastSector; i++) {
         synchDisk->ReadSector(hdr->ByteToSector(i * SECTOR_SIZE),
                               &buf[(i - firstSector) * SECTOR_SIZE]);
@@ -136,7 +136,7 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
 
     // Copy the part we want.
     memcpy(into, &buf[position - firstSector * SECTOR_SIZE], numBytes);
-    delete [] buf;
+    FreeBuffer(buf, numSectors * SECTOR_SIZE);
     return numBytes;
 }
 
@@ -164,7 +164,7 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     lastSector  = DivRoundDown(position + numBytes - 1, SECTOR_SIZE);
     numSectors  = 1 + lastSector - firstSector;
 
-    buf = new char [numSectors * SECTOR_SIZE];
+    buf = AllocBuffer(numSectors * SECTOR_SIZE);
 
     firstAligned = position == firstSector * SECTOR_SIZE;
     lastAligned  = position + numBytes == (lastSector + 1) * SECTOR_SIZE;
@@ -186,7 +186,7 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
         synchDisk->WriteSector(hdr->ByteToSector(i * SECTOR_SIZE),
                                &buf[(i - firstSector) * SECTOR_SIZE]);
     }
-    delete [] buf;
+    FreeBuffer(buf, numSectors * SECTOR_SIZE);
     return numBytes;
 }
 
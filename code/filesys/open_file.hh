@@ -21,12 +21,14 @@
 
 
 #include "lib/utility.hh"
+#include "lib/slab.hh"
 
 
 #ifdef FILESYS_STUB  // Temporarily implement calls to Nachos file system as
                      // calls to UNIX!  See definitions listed under `#else`.
 class OpenFile {
 public:
+    SLAB_ALLOCATED(OpenFile)
 
     /// Open the file.
     OpenFile(int f)
@@ -89,6 +91,7 @@ class FileHeader;
 
 class OpenFile {
 public:
+    SLAB_ALLOCATED(OpenFile)
 
     /// Open a file whose header is located at `sector` on the disk.
     OpenFile(int sector);
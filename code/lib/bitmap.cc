@@ -10,28 +10,45 @@
 #include "bitmap.hh"
 
 #include <stdio.h>
+#include <string.h>
 
 
+/// A word with every bit set.
+static const unsigned FULL_WORD = ~0u;
+
+/// Smallest number of words for which a summary is kept; below this, a
+/// plain scan is just as fast.
+static const unsigned MIN_SUMMARY_WORDS = BITS_IN_WORD;
+
 /// Initialize a bitmap with `nitems` bits, so that every bit is clear.  It
 /// can be added somewhere on a list.
 ///
 /// * `nitems` is the number of bits in the bitmap.
-Bitmap::Bitmap(unsigned nitems)
+/// * `summarize` tells whether to keep a summary of the full words.
+Bitmap::Bitmap(unsigned nitems, bool summarize)
 {
     ASSERT(nitems > 0);
 
     numBits  = nitems;
     numWords = DivRoundUp(numBits, BITS_IN_WORD);
     map      = new unsigned [numWords];
-    for (unsigned i = 0; i < numBits; i++) {
-        Clear(i);
+    memset(map, 0, numWords * sizeof *map);
+
+    if (summarize && numWords >= MIN_SUMMARY_WORDS) {
+        numSummaryWords = DivRoundUp(numWords, BITS_IN_WORD);
+        summary = new unsigned [numSummaryWords];
+    } else {
+        numSummaryWords = 0;
+        summary = nullptr;
     }
+    Rebuild();
 }
 
 /// De-allocate a bitmap.
 Bitmap::~Bitmap()
 {
     delete [] map;
+    delete [] summary;
 }
 
 /// Set the “nth” bit in a bitmap.
@@ -41,7 +58,16 @@ void
 Bitmap::Mark(unsigned which)
 {
     ASSERT(which < numBits);
-    map[which / BITS_IN_WORD] |= 1 << which % BITS_IN_WORD;
+
+    unsigned w = which / BITS_IN_WORD;
+    unsigned bit = 1u << which % BITS_IN_WORD;
+    if (!(map[w] & bit)) {
+        map[w] |= bit;
+        numClear--;
+        if (map[w] == FULL_WORD) {
+            UpdateSummary(w);
+        }
+    }
 }
 
 /// Clear the “nth” bit in a bitmap.
@@ -51,7 +77,28 @@ void
 Bitmap::Clear(unsigned which)
 {
     ASSERT(which < numBits);
-    map[which / BITS_IN_WORD] &= ~(1 << which % BITS_IN_WORD);
+
+    unsigned w = which / BITS_IN_WORD;
+    unsigned bit = 1u << which % BITS_IN_WORD;
+    if (map[w] & bit) {
+        if (map[w] == FULL_WORD) {
+            map[w] &= ~bit;
+            UpdateSummary(w);
+        } else {
+            map[w] &= ~bit;
+        }
+        numClear++;
+        if (w < firstFree) {
+            firstFree = w;
+        }
+        if (rangeLength != 0) {
+            // The run that now holds `which` may be long enough.
+            unsigned start = RunStart(which, rangeStart);
+            if (start < rangeStart) {
+                rangeStart = start;
+            }
+        }
+    }
 }
 
 /// Return true if the “nth” bit is set.
@@ -71,13 +118,137 @@ Bitmap::Test(unsigned which) const
 int
 Bitmap::Find()
 {
-    for (unsigned i = 0; i < numBits; i++) {
-        if (!Test(i)) {
-            Mark(i);
-            return i;
+    unsigned w = FindWord(firstFree);
+    firstFree = w;
+    if (w == numWords) {
+        return -1;
+    }
+
+    unsigned which = w * BITS_IN_WORD + __builtin_ctz(~map[w]);
+    Mark(which);
+    return which;
+}
+
+/// Return the number of the first clear bit at or after `hint`, or if
+/// there is none, the first clear bit before it.  As a side effect, set the
+/// bit.
+///
+/// Useful to keep related items close together, for instance the sectors
+/// of a file.
+///
+/// If no bits are clear, return -1.
+int
+Bitmap::FindNear(unsigned hint)
+{
+    if (hint >= numBits) {
+        hint = 0;
+    }
+
+    unsigned w = hint / BITS_IN_WORD;
+    unsigned clear = ~map[w] & FULL_WORD << hint % BITS_IN_WORD;
+    if (clear == 0) {
+        w = FindWord(w + 1);
+        if (w == numWords) {
+            w = FindWord(firstFree);  // Wrap around.
+            if (w == numWords) {
+                return -1;
+            }
+        }
+        clear = ~map[w];
+    }
+
+    unsigned which = w * BITS_IN_WORD + __builtin_ctz(clear);
+    Mark(which);
+    return which;
+}
+
+/// Return the number of the first bit of a run of `n` clear bits, and set
+/// them all.  The first run that is long enough is taken.
+///
+/// Runs are followed a word at a time: a run that reaches the top of a word
+/// carries on into the next one, and runs inside a word are found by
+/// shifting and masking.
+///
+/// If there is no such run, return -1.
+int
+Bitmap::FindRange(unsigned n)
+{
+    ASSERT(n > 0);
+
+    if (n > numClear) {
+        return -1;
+    }
+
+    // Skip the part of the map that an earlier search found to have no run
+    // long enough.
+    unsigned from = firstFree;
+    if (rangeLength != 0 && n >= rangeLength
+          && rangeStart / BITS_IN_WORD > from) {
+        from = rangeStart / BITS_IN_WORD;
+    }
+
+    // Run of clear bits that reaches the top of the previous word.
+    unsigned start = 0, length = 0;
+    for (unsigned w = FindWord(from); w < numWords; w++) {
+        unsigned word = map[w];
+        if (word == 0) {
+            if (length == 0) {
+                start = w * BITS_IN_WORD;
+            }
+            length += BITS_IN_WORD;
+            if (length >= n) {
+                break;
+            }
+            continue;
+        }
+
+        // Clear bits at the bottom of this word may complete the run.
+        if (length > 0 && length + __builtin_ctz(word) >= n) {
+            length = n;
+            break;
+        }
+
+        // Look for the run inside the word: after the loop, a bit of
+        // `starts` is set if it begins `n` clear bits.
+        if (n <= BITS_IN_WORD) {
+            unsigned starts = ~word;
+            for (unsigned have = 1; have < n && starts != 0;) {
+                unsigned shift = have < n - have ? have : n - have;
+                starts &= starts >> shift;
+                have += shift;
+            }
+            if (starts != 0) {
+                start = w * BITS_IN_WORD + __builtin_ctz(starts);
+                length = n;
+                break;
+            }
+        }
+
+        if (word == FULL_WORD) {
+            length = 0;
+            w = FindWord(w + 1) - 1;
+        } else {
+            length = __builtin_clz(word);
+            start = (w + 1) * BITS_IN_WORD - length;
         }
     }
-    return -1;
+
+    if (length < n) {
+        start = numBits;
+    }
+    // First fit: no run of `n` bits begins before `start`.
+    if (rangeLength == 0 || n <= rangeLength) {
+        rangeLength = n;
+        rangeStart = start;
+    }
+    if (length < n) {
+        return -1;
+    }
+
+    for (unsigned i = start; i < start + n; i++) {
+        Mark(i);
+    }
+    return start;
 }
 
 /// Return the number of clear bits in the bitmap.  (In other words, how many
@@ -85,14 +256,99 @@ Bitmap::Find()
 unsigned
 Bitmap::CountClear() const
 {
-    unsigned count = 0;
+    return numClear;
+}
 
-    for (unsigned i = 0; i < numBits; i++) {
-        if (!Test(i)) {
-            count++;
+unsigned
+Bitmap::FindWord(unsigned from) const
+{
+    if (from >= numWords) {
+        return numWords;
+    }
+
+    if (summary == nullptr) {
+        for (unsigned w = from; w < numWords; w++) {
+            if (map[w] != FULL_WORD) {
+                return w;
+            }
+        }
+        return numWords;
+    }
+
+    // Look for a clear bit in the summary, that is, a word that is not
+    // full.  Summary bits past `numWords` are set, so they are not found.
+    unsigned s = from / BITS_IN_WORD;
+    unsigned notFull = ~summary[s] & FULL_WORD << from % BITS_IN_WORD;
+    while (notFull == 0) {
+        if (++s == numSummaryWords) {
+            return numWords;
+        }
+        notFull = ~summary[s];
+    }
+    return s * BITS_IN_WORD + __builtin_ctz(notFull);
+}
+
+void
+Bitmap::UpdateSummary(unsigned w)
+{
+    if (summary == nullptr) {
+        return;
+    }
+
+    unsigned bit = 1u << w % BITS_IN_WORD;
+    if (map[w] == FULL_WORD) {
+        summary[w / BITS_IN_WORD] |= bit;
+    } else {
+        summary[w / BITS_IN_WORD] &= ~bit;
+    }
+}
+
+void
+Bitmap::Rebuild()
+{
+    // Bits past the end are never handed out.
+    unsigned extra = numWords * BITS_IN_WORD - numBits;
+    if (extra > 0) {
+        map[numWords - 1] |= FULL_WORD << (BITS_IN_WORD - extra);
+    }
+
+    numClear = 0;
+    for (unsigned w = 0; w < numWords; w++) {
+        numClear += __builtin_popcount(~map[w]);
+    }
+
+    if (summary != nullptr) {
+        memset(summary, 0, numSummaryWords * sizeof *summary);
+        for (unsigned w = 0; w < numWords; w++) {
+            UpdateSummary(w);
+        }
+        for (unsigned w = numWords; w < numSummaryWords * BITS_IN_WORD;
+             w++) {
+            summary[w / BITS_IN_WORD] |= 1u << w % BITS_IN_WORD;
+        }
+    }
+
+    firstFree = 0;
+    firstFree = FindWord(0);
+    rangeLength = 0;
+}
+
+unsigned
+Bitmap::RunStart(unsigned which, unsigned floor) const
+{
+    ASSERT(which < numBits);
+
+    unsigned w = which / BITS_IN_WORD;
+    unsigned below = map[w] & ((1u << which % BITS_IN_WORD) - 1);
+    while (below == 0) {
+        if (w * BITS_IN_WORD <= floor) {
+            // No need to look further: no run starts before `firstFree`.
+            return firstFree * BITS_IN_WORD;
         }
+        below = map[--w];
     }
-    return count;
+    // The run starts right above the highest set bit.
+    return (w + 1) * BITS_IN_WORD - __builtin_clz(below);
 }
 
 /// Print the contents of the bitmap, for debugging.
@@ -121,6 +377,7 @@ Bitmap::FetchFrom(OpenFile *file)
 {
     ASSERT(file != nullptr);
     file->ReadAt((char *) map, numWords * sizeof (unsigned), 0);
+    Rebuild();
 }
 
 /// Store the contents of a bitmap to a Nachos file.
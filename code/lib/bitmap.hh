@@ -3,7 +3,10 @@
 /// vector.
 ///
 /// The bitmap is represented as an array of unsigned integers, on which we
-/// do modulo arithmetic to find the bit we are interested in.
+/// do modulo arithmetic to find the bit we are interested in.  Searches go a
+/// word at a time; large bitmaps also keep a summary with one bit per word,
+/// set when the word is full, so that runs of full words are skipped 32 at a
+/// time.
 ///
 /// The data structure is parameterized with with the number of bits being
 /// managed.
@@ -36,7 +39,9 @@ public:
     /// Initialize a bitmap with `nitems` bits; all bits are cleared.
     ///
     /// * `nitems` is the number of items in the bitmap.
-    Bitmap(unsigned nitems);
+    /// * `summarize` tells whether to keep a summary of the full words, if
+    ///   the bitmap is large enough for it to pay off.
+    Bitmap(unsigned nitems, bool summarize = true);
 
     /// Uninitialize a bitmap.
     ~Bitmap();
@@ -55,6 +60,16 @@ public:
     /// If no bits are clear, return -1.
     int Find();
 
+    /// Like `Find`, but look for the first clear bit at or after `hint`,
+    /// wrapping around to the beginning.
+    int FindNear(unsigned hint);
+
+    /// Return the index of the first of `n` consecutive clear bits, and set
+    /// them all.
+    ///
+    /// If there is no such range, return -1.
+    int FindRange(unsigned n);
+
     /// Return the number of clear bits.
     unsigned CountClear() const;
 
@@ -82,9 +97,44 @@ private:
     /// multiple of the number of bits in a word).
     unsigned numWords;
 
-    /// Bit storage.
+    /// Bit storage.  Bits past `numBits` in the last word are kept set, so
+    /// that they are never found.
     unsigned *map;
 
+    /// Number of clear bits.
+    unsigned numClear;
+
+    /// Every word of `map` below this one is full.
+    unsigned firstFree;
+
+    /// One bit per word of `map`, set if the word is full; null if the
+    /// bitmap is small or has no summary.
+    unsigned *summary;
+    unsigned numSummaryWords;
+
+    /// No run of `rangeLength` or more clear bits begins before the bit
+    /// `rangeStart`, as found by the last `FindRange`; `rangeLength` is 0 if
+    /// unknown.
+    unsigned rangeLength;
+    unsigned rangeStart;
+
+    /// Recompute `numClear`, `firstFree`, `summary` and the range hint from
+    /// `map`.
+    void Rebuild();
+
+    /// Return the first bit of the run of clear bits that ends at `which`.
+    ///
+    /// If the run reaches down to the word of `floor`, a lower bound is
+    /// returned instead.
+    unsigned RunStart(unsigned which, unsigned floor) const;
+
+    /// Return the first word at or after `from` with a clear bit, or
+    /// `numWords` if there is none.
+    unsigned FindWord(unsigned from) const;
+
+    /// Record in the summary whether the word `w` is full.
+    void UpdateSummary(unsigned w);
+
 };
 
 
@@ -0,0 +1,118 @@
+/// Microbenchmark for bitmaps.
+///
+/// For sizes from 1K to 1M bits, time the operations of `Bitmap` on a
+/// bitmap filled up and then fragmented at random, with and without the
+/// summary of full words.  Results are checked against `Test` as we go, so
+/// this doubles as a sanity test.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "bitmap.hh"
+#include "machine/system_dep.hh"
+
+#include <stdio.h>
+#include <time.h>
+
+
+static const unsigned MIN_BITS = 1 << 10;
+static const unsigned MAX_BITS = 1 << 20;
+
+/// Number of operations timed for each measurement.
+static const unsigned NUM_OPS = 1 << 14;
+
+static double
+Now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/// Time `Find` and `FindNear` on a nearly full bitmap, `FindRange` and
+/// `CountClear` on a fragmented one.  Prints nanoseconds per operation.
+static void
+Measure(unsigned numBits, bool summarize)
+{
+    Bitmap map(numBits, summarize);
+
+    // Fill it completely.
+    for (unsigned i = 0; i < numBits; i++) {
+        ASSERT(map.Find() == (int) i);
+    }
+    ASSERT(map.Find() == -1);
+    ASSERT(map.CountClear() == 0);
+
+    // Free bits at random, then allocate them again.  Every search has to
+    // get past the full words.
+    unsigned ops = NUM_OPS < numBits / 2 ? NUM_OPS : numBits / 2;
+    for (unsigned i = 0; i < ops; i++) {
+        map.Clear(SystemDep::Random() % numBits);
+    }
+    unsigned freed = map.CountClear();
+    double start = Now();
+    for (unsigned i = 0; i < freed; i++) {
+        ASSERT(map.Find() != -1);
+    }
+    double find = (Now() - start) / freed;
+    ASSERT(map.CountClear() == 0);
+
+    for (unsigned i = 0; i < ops; i++) {
+        map.Clear(SystemDep::Random() % numBits);
+    }
+    freed = map.CountClear();
+    start = Now();
+    for (unsigned i = 0; i < freed; i++) {
+        unsigned hint = SystemDep::Random() % numBits;
+        int which = map.FindNear(hint);
+        ASSERT(which != -1 && map.Test(which));
+    }
+    double findNear = (Now() - start) / freed;
+
+    // Fragment the bitmap: free a random run of 1 to 16 bits every 64.
+    for (unsigned i = 0; i + 64 <= numBits; i += 64) {
+        unsigned length = 1 + SystemDep::Random() % 16;
+        for (unsigned j = 0; j < length; j++) {
+            map.Clear(i + j);
+        }
+    }
+    unsigned ranges = 0;
+    start = Now();
+    for (unsigned i = 0; i < ops; i++) {
+        int first = map.FindRange(8);
+        if (first == -1) {
+            break;
+        }
+        for (unsigned j = 0; j < 8; j++) {
+            ASSERT(map.Test(first + j));
+        }
+        ranges++;
+    }
+    double findRange = ranges > 0 ? (Now() - start) / ranges : 0;
+
+    start = Now();
+    unsigned long total = 0;
+    for (unsigned i = 0; i < ops; i++) {
+        total += map.CountClear();
+    }
+    double countClear = (Now() - start) / ops;
+    ASSERT(total == (unsigned long) map.CountClear() * ops);
+
+    printf("%8u %8s %10.1f %10.1f %10.1f %10.1f\n",
+           numBits, summarize ? "yes" : "no",
+           find, findNear, findRange, countClear);
+}
+
+void
+BitmapPerformanceTest()
+{
+    printf("Bitmap operations, in nanoseconds:\n");
+    printf("%8s %8s %10s %10s %10s %10s\n", "bits", "summary",
+           "Find", "FindNear", "FindRange", "CountClear");
+    for (unsigned numBits = MIN_BITS; numBits <= MAX_BITS; numBits *= 4) {
+        Measure(numBits, false);
+        Measure(numBits, true);
+    }
+}
@@ -15,6 +15,8 @@
 /// * `a` -- address spaces (requires *USER_PROGRAM*).
 /// * `e` -- exception handling (requires *USER_PROGRAM*).
 /// * `n` -- network emulation (requires *NETWORK*).
+/// * `w` -- working sets and admission control (requires *VMEM*).
+/// * `k` -- kernel object caches.
 ///
 /// See also `debug_opts.hh`.
 ///
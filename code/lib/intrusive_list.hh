@@ -0,0 +1,309 @@
+/// Data structures to manage intrusive lists.
+///
+/// An intrusive list does not allocate anything to keep track of its items:
+/// each item carries a `ListLink` of its own, and the list threads its
+/// items together through it.  Putting an item on a list, taking it off and
+/// checking whether it is there are all constant time, and never touch the
+/// heap.
+///
+/// The price is that an item can only be on one list per `ListLink` it
+/// has.  Thread control blocks, for instance, have one link for the queue
+/// they wait on (ready list or semaphore queue, never both at once) and
+/// another one for the list of suspended threads.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_INTRUSIVELIST__HH
+#define NACHOS_LIB_INTRUSIVELIST__HH
+
+
+#include "utility.hh"
+
+
+template <class Item> class ListLink;
+template <class Item, ListLink<Item> Item::*link> class IntrusiveList;
+
+/// The link fields an item needs to be on an `IntrusiveList`.
+///
+/// Embed one in the item, and name it in the type of the list; for
+/// example `IntrusiveList<Thread, &Thread::queueLink>`.
+template <class Item>
+class ListLink {
+public:
+
+    /// Initialize a link that is not on any list.
+    ListLink();
+
+    /// Is the item on some list through this link?
+    bool IsLinked() const;
+
+    /// The key the item was inserted with, for a sorted list.
+    unsigned long GetKey() const;
+
+private:
+    template <class I, ListLink<I> I::*> friend class IntrusiveList;
+
+    Item *next;  ///< Next item on the list, null if this is the last.
+    Item *prev;  ///< Previous item on the list, null if this is the first.
+    const void *owner;   ///< List the item is on, null if none.
+    unsigned long key;   ///< Priority, for a sorted list.
+};
+
+/// The following class defines an intrusive “list” -- a doubly linked list
+/// of items, each of which holds the links to its neighbours.
+///
+/// The interface follows the one of `List`.  By using the `Sorted`
+/// functions, the list can be kept sorted in increasing order by key.
+template <class Item, ListLink<Item> Item::*link>
+class IntrusiveList {
+public:
+
+    /// Initialize the list.
+    IntrusiveList();
+
+    /// Take all items off the list.
+    ~IntrusiveList();
+
+    /// Put item at the beginning of the list.
+    void Prepend(Item *item);
+
+    /// Put item at the end of the list.
+    void Append(Item *item);
+
+    /// Get the item on the front of the list.
+    Item *Head() const;
+
+    /// Get the item after `item`, which must be on the list; null if it is
+    /// the last one.
+    Item *Next(Item *item) const;
+
+    /// Take item off the front of the list.
+    Item *Pop();
+
+    /// Take item off the list, if it is on it.
+    void Remove(Item *item);
+
+    /// Apply `func` to all elements in list.
+    void Apply(void (*func)(Item *)) const;
+
+    /// Does the list have some item?
+    bool Has(Item *item) const;
+
+    /// Is the list empty?
+    bool IsEmpty() const;
+
+    /// Routines to put/get items on/off list in order (sorted by key).
+
+    /// Put item into list, after the items with the same key.
+    void SortedInsert(Item *item, unsigned long sortKey);
+
+    /// Remove first item from list.
+    Item *SortedPop(unsigned long *keyPtr);
+
+private:
+
+    Item *first;  ///< Head of the list, null if list is empty.
+    Item *last;   ///< Last element of list.
+
+    /// Insert `item` between `before` and `after`, either of which may be
+    /// null.
+    void Insert(Item *item, Item *before, Item *after);
+};
+
+template <class Item>
+ListLink<Item>::ListLink()
+{
+    next = prev = nullptr;
+    owner = nullptr;
+    key = 0;
+}
+
+template <class Item>
+bool
+ListLink<Item>::IsLinked() const
+{
+    return owner != nullptr;
+}
+
+template <class Item>
+unsigned long
+ListLink<Item>::GetKey() const
+{
+    return key;
+}
+
+template <class Item, ListLink<Item> Item::*link>
+IntrusiveList<Item, link>::IntrusiveList()
+{
+    first = last = nullptr;
+}
+
+/// The items themselves are not de-allocated, only unlinked.
+template <class Item, ListLink<Item> Item::*link>
+IntrusiveList<Item, link>::~IntrusiveList()
+{
+    while (!IsEmpty()) {
+        Pop();
+    }
+}
+
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::Insert(Item *item, Item *before, Item *after)
+{
+    ListLink<Item> &l = item->*link;
+
+    // An item can be on a single list per link.
+    ASSERT(!l.IsLinked());
+
+    l.prev = before;
+    l.next = after;
+    l.owner = this;
+    if (before != nullptr) {
+        (before->*link).next = item;
+    } else {
+        first = item;
+    }
+    if (after != nullptr) {
+        (after->*link).prev = item;
+    } else {
+        last = item;
+    }
+}
+
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::Prepend(Item *item)
+{
+    ASSERT(item != nullptr);
+
+    Insert(item, nullptr, first);
+}
+
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::Append(Item *item)
+{
+    ASSERT(item != nullptr);
+
+    Insert(item, last, nullptr);
+}
+
+/// The list must not be empty.  The item is not removed from the list.
+template <class Item, ListLink<Item> Item::*link>
+Item *
+IntrusiveList<Item, link>::Head() const
+{
+    ASSERT(!IsEmpty());
+
+    return first;
+}
+
+template <class Item, ListLink<Item> Item::*link>
+Item *
+IntrusiveList<Item, link>::Next(Item *item) const
+{
+    ASSERT(Has(item));
+
+    return (item->*link).next;
+}
+
+/// Returns the removed item, null if nothing on the list.
+template <class Item, ListLink<Item> Item::*link>
+Item *
+IntrusiveList<Item, link>::Pop()
+{
+    return SortedPop(nullptr);
+}
+
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::Remove(Item *item)
+{
+    ASSERT(item != nullptr);
+
+    if (!Has(item)) {
+        return;
+    }
+
+    ListLink<Item> &l = item->*link;
+    if (l.prev != nullptr) {
+        (l.prev->*link).next = l.next;
+    } else {
+        first = l.next;
+    }
+    if (l.next != nullptr) {
+        (l.next->*link).prev = l.prev;
+    } else {
+        last = l.prev;
+    }
+    l.next = l.prev = nullptr;
+    l.owner = nullptr;
+}
+
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::Apply(void (*func)(Item *)) const
+{
+    ASSERT(func != nullptr);
+
+    for (Item *ptr = first; ptr != nullptr; ptr = (ptr->*link).next) {
+        func(ptr);
+    }
+}
+
+template <class Item, ListLink<Item> Item::*link>
+bool
+IntrusiveList<Item, link>::Has(Item *item) const
+{
+    ASSERT(item != nullptr);
+
+    return (item->*link).owner == this;
+}
+
+template <class Item, ListLink<Item> Item::*link>
+bool
+IntrusiveList<Item, link>::IsEmpty() const
+{
+    return first == nullptr;
+}
+
+/// Walk the list backwards from the end, so that appending in key order,
+/// the common case for the pending interrupts, takes constant time.
+template <class Item, ListLink<Item> Item::*link>
+void
+IntrusiveList<Item, link>::SortedInsert(Item *item, unsigned long sortKey)
+{
+    ASSERT(item != nullptr);
+
+    Item *ptr = last;
+    while (ptr != nullptr && sortKey < (ptr->*link).key) {
+        ptr = (ptr->*link).prev;
+    }
+    Insert(item, ptr, ptr != nullptr ? (ptr->*link).next : first);
+    (item->*link).key = sortKey;
+}
+
+/// Returns the removed item, null if nothing on the list.
+///
+/// Sets `*keyPtr` to the key of the removed item, if `keyPtr` is not null.
+template <class Item, ListLink<Item> Item::*link>
+Item *
+IntrusiveList<Item, link>::SortedPop(unsigned long *keyPtr)
+{
+    Item *thing = first;
+
+    if (thing == nullptr) {
+        return nullptr;
+    }
+    if (keyPtr != nullptr) {
+        *keyPtr = (thing->*link).key;
+    }
+    Remove(thing);
+    return thing;
+}
+
+
+#endif
@@ -37,6 +37,12 @@ public:
 ///
 /// By using the `Sorted` functions, the list can be kept in sorted in
 /// increasing order by `key` in `ListElement`.
+///
+/// List elements are not given back to the heap when items are taken off a
+/// list, but kept in a pool shared by all lists of the same type, so that
+/// once the lists have grown to their working size, putting items on them
+/// allocates nothing.  For lists of objects that are always on at most one
+/// list of a kind, `IntrusiveList` saves the list elements altogether.
 template <class Item>
 class List {
 public:
@@ -84,8 +90,20 @@ private:
 
     ListNode *first;  ///< Head of the list, null if list is empty.
     ListNode *last;   ///< Last element of list.
+
+    /// Get a list element for `item`, from the pool if it is not empty.
+    static ListNode *NewNode(Item item, int sortKey);
+
+    /// Put a list element no longer in use back in the pool.
+    static void FreeNode(ListNode *node);
+
+    /// Pool of unused list elements, linked through `next`.
+    static ListNode *freeNodes;
 };
 
+template <class Item>
+ListElement<Item> *List<Item>::freeNodes = nullptr;
+
 /// Initialize a list element, so it can be added somewhere on a list.
 ///
 /// * `anItem` is the item to be put on the list.
@@ -98,6 +116,30 @@ ListElement<Item>::ListElement(Item anItem, int sortKey)
      next = nullptr;  // Assume we will put it at the end of the list.
 }
 
+template <class Item>
+ListElement<Item> *
+List<Item>::NewNode(Item item, int sortKey)
+{
+    ListNode *node = freeNodes;
+    if (node == nullptr) {
+        return new ListNode(item, sortKey);
+    }
+    freeNodes = node->next;
+    node->item = item;
+    node->key  = sortKey;
+    node->next = nullptr;
+    return node;
+}
+
+template <class Item>
+void
+List<Item>::FreeNode(ListNode *node)
+{
+    node->item = Item();
+    node->next = freeNodes;
+    freeNodes = node;
+}
+
 /// Initialize a list, empty to start with.
 ///
 /// Elements can now be added to the list.
@@ -109,11 +151,11 @@ List<Item>::List()
 
 /// Prepare a list for deallocation.
 ///
-/// If the list still contains any `ListElement`s, de-allocate them.
-/// However, note that we do *not* de-allocate the “items” on the list --
-/// this module allocates and de-allocates the `ListElement`s to keep track
-/// of each item, but a given item may be on multiple lists, so we cannot
-/// de-allocate them here.
+/// If the list still contains any `ListElement`s, give them back to the
+/// pool.  However, note that we do *not* de-allocate the “items” on the
+/// list -- this module allocates and recycles the `ListElement`s to keep
+/// track of each item, but a given item may be on multiple lists, so we
+/// cannot de-allocate them here.
 template <class Item>
 List<Item>::~List()
 {
@@ -125,7 +167,7 @@ List<Item>::~List()
 
 // Append an “item” to the end of the list.
 //
-// Allocate a `ListElement` to keep track of the item.  If the list is empty,
+// Take a `ListElement` to keep track of the item.  If the list is empty,
 // then this will be the only element.  Otherwise, put it at the end.
 //
 // * `item` is the thing to put on the list, it can be a pointer to anything.
@@ -133,7 +175,7 @@ template <class Item>
 void
 List<Item>::Append(Item item)
 {
-    ListNode *element = new ListNode(item, 0);
+    ListNode *element = NewNode(item, 0);
 
     if (IsEmpty()) {
         first = element;
@@ -146,7 +188,7 @@ List<Item>::Append(Item item)
 
 /// Put an "item" on the front of the list.
 ///
-/// Allocate a `ListElement` to keep track of the item.  If the list is
+/// Take a `ListElement` to keep track of the item.  If the list is
 /// empty, then this will be the only element.  Otherwise, put it at the
 /// beginning.
 ///
@@ -156,7 +198,7 @@ template <class Item>
 void
 List<Item>::Prepend(Item item)
 {
-    ListNode *element = new ListNode(item, 0);
+    ListNode *element = NewNode(item, 0);
 
     if (IsEmpty()) {
         first = element;
@@ -209,7 +251,7 @@ List<Item>::Remove(Item item)
             if (last == ptr) {
                 last = prev_ptr;
             }
-            delete ptr;
+            FreeNode(ptr);
             return;
         }
     }
@@ -253,7 +295,7 @@ List<Item>::IsEmpty() const
 /// Insert an `item` into a list, so that the list elements are sorted in
 /// increasing order by `sortKey`.
 ///
-/// Allocate a `ListElement` to keep track of the item.  If the list is
+/// Take a `ListElement` to keep track of the item.  If the list is
 /// empty, then this will be the only element.  Otherwise, walk through the
 /// list, one element at a time, to find where the new item should be placed.
 ///
@@ -264,7 +306,7 @@ template <class Item>
 void
 List<Item>::SortedInsert(Item item, int sortKey)
 {
-    ListNode *element = new ListNode(item, sortKey);
+    ListNode *element = NewNode(item, sortKey);
 
     if (IsEmpty()) {  // If list is empty, put.
         first = element;
@@ -315,7 +357,7 @@ List<Item>::SortedPop(int *keyPtr)
     if (keyPtr != nullptr) {
         *keyPtr = element->key;
     }
-    delete element;
+    FreeNode(element);
     return thing;
 }
 
@@ -0,0 +1,177 @@
+/// Routines to manage object caches.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "slab.hh"
+
+#include <stdio.h>
+
+
+/// Bytes taken from the heap at a time, unless objects are so large that
+/// fewer than `MIN_OBJECTS_PER_SLAB` would fit.
+static const size_t SLAB_SIZE = 8192;
+static const unsigned MIN_OBJECTS_PER_SLAB = 8;
+
+/// Objects are laid out at multiples of this, which is what `new`
+/// guarantees.
+static const size_t OBJECT_ALIGNMENT = 16;
+
+/// Smallest buffer cache.
+static const size_t MIN_BUFFER_SIZE = 16;
+
+SlabCache *SlabCache::caches = nullptr;
+
+SlabCache::SlabCache(const char *name_, size_t objectSize_)
+{
+    ASSERT(name_ != nullptr);
+    ASSERT(objectSize_ > 0);
+
+    name = name_;
+    objectSize = (objectSize_ + OBJECT_ALIGNMENT - 1)
+                 / OBJECT_ALIGNMENT * OBJECT_ALIGNMENT;
+    objectsPerSlab = SLAB_SIZE / objectSize;
+    if (objectsPerSlab < MIN_OBJECTS_PER_SLAB) {
+        objectsPerSlab = MIN_OBJECTS_PER_SLAB;
+    }
+    freeList = nullptr;
+    numAllocs = numFrees = 0;
+    peakLive = 0;
+    numSlabs = 0;
+
+    // Keep the report in order of creation.
+    next = nullptr;
+    SlabCache **last = &caches;
+    while (*last != nullptr) {
+        last = &(*last)->next;
+    }
+    *last = this;
+}
+
+void
+SlabCache::Grow()
+{
+    char *slab = new char [objectsPerSlab * objectSize];
+
+    // Link the objects from the last one, so that they are handed out in
+    // address order.
+    for (unsigned i = objectsPerSlab; i > 0; i--) {
+        void *object = slab + (i - 1) * objectSize;
+        *(void **) object = freeList;
+        freeList = object;
+    }
+    numSlabs++;
+    DEBUG('k', "Slab cache %s grows to %u slabs\n", name, numSlabs);
+}
+
+void *
+SlabCache::Alloc()
+{
+    if (freeList == nullptr) {
+        Grow();
+    }
+
+    void *object = freeList;
+    freeList = *(void **) object;
+
+    numAllocs++;
+    if (GetLive() > peakLive) {
+        peakLive = GetLive();
+    }
+    return object;
+}
+
+void
+SlabCache::Free(void *object)
+{
+    if (object == nullptr) {
+        return;
+    }
+    ASSERT(GetLive() > 0);
+
+    *(void **) object = freeList;
+    freeList = object;
+    numFrees++;
+}
+
+size_t
+SlabCache::GetObjectSize() const
+{
+    return objectSize;
+}
+
+unsigned
+SlabCache::GetLive() const
+{
+    return numAllocs - numFrees;
+}
+
+void
+SlabCache::PrintAll()
+{
+    bool any = false;
+    for (SlabCache *c = caches; c != nullptr; c = c->next) {
+        if (c->numAllocs == 0) {
+            continue;
+        }
+        if (!any) {
+            printf("Slab caches:\n");
+            any = true;
+        }
+        printf("    %-16s size %4zu, allocs %lu, live %u (peak %u), "
+               "slabs %u\n", c->name, c->objectSize, c->numAllocs,
+               c->GetLive(), c->peakLive, c->numSlabs);
+    }
+}
+
+/// Names of the buffer caches, by size.
+static const char *BUFFER_NAMES[] = {
+    "buffer 16", "buffer 32", "buffer 64", "buffer 128", "buffer 256",
+    "buffer 512", "buffer 1024", "buffer 2048", "buffer 4096"
+};
+static const unsigned NUM_BUFFER_CACHES
+  = sizeof BUFFER_NAMES / sizeof BUFFER_NAMES[0];
+
+static SlabCache *bufferCaches[NUM_BUFFER_CACHES];
+
+/// The buffer cache for `size`, created if needed; null if `size` is
+/// too large.
+static SlabCache *
+BufferCache(size_t size)
+{
+    unsigned i = 0;
+    size_t cacheSize = MIN_BUFFER_SIZE;
+    while (cacheSize < size) {
+        cacheSize *= 2;
+        i++;
+    }
+    if (cacheSize > MAX_BUFFER_SIZE) {
+        return nullptr;
+    }
+    ASSERT(i < NUM_BUFFER_CACHES);
+
+    if (bufferCaches[i] == nullptr) {
+        bufferCaches[i] = new SlabCache(BUFFER_NAMES[i], cacheSize);
+    }
+    return bufferCaches[i];
+}
+
+char *
+AllocBuffer(size_t size)
+{
+    SlabCache *cache = BufferCache(size);
+    return cache != nullptr ? (char *) cache->Alloc() : new char [size];
+}
+
+void
+FreeBuffer(char *buffer, size_t size)
+{
+    SlabCache *cache = BufferCache(size);
+    if (cache != nullptr) {
+        cache->Free(buffer);
+    } else {
+        delete [] buffer;
+    }
+}
@@ -0,0 +1,119 @@
+/// Object caches for kernel objects that come and go all the time.
+///
+/// A `SlabCache` hands out objects of a single size, carved out of larger
+/// blocks (“slabs”) taken from the heap.  Freed objects go on a free list
+/// and are handed out again before any new slab is taken, so that once a
+/// cache has grown to the number of objects the kernel keeps alive at a
+/// time, allocating from it is a couple of pointer moves.  Slabs are never
+/// given back to the heap.
+///
+/// A class is moved onto a cache of its own by putting `SLAB_ALLOCATED` in
+/// its declaration, which gives it its own `operator new` and
+/// `operator delete`.  Byte buffers of any size can be taken from a set of
+/// caches of powers of two, with `AllocBuffer` and `FreeBuffer`.
+///
+/// Every cache counts the objects it hands out, and `PrintAll` reports them
+/// when the machine halts.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_SLAB__HH
+#define NACHOS_LIB_SLAB__HH
+
+
+#include "utility.hh"
+
+#include <stddef.h>
+
+
+class SlabCache {
+public:
+
+    /// Create an empty cache for objects of `objectSize` bytes.
+    ///
+    /// * `name` is printed in the report; it is not copied.
+    ///
+    /// Caches are never destroyed: objects may be freed until the very
+    /// end.
+    SlabCache(const char *name, size_t objectSize);
+
+    /// Return room for an object, taking a new slab if there is none free.
+    void *Alloc();
+
+    /// Put the room for an object back on the free list.
+    void Free(void *object);
+
+    size_t GetObjectSize() const;
+
+    /// Objects handed out and not freed yet.
+    unsigned GetLive() const;
+
+    /// Print the counters of every cache that has handed out something.
+    static void PrintAll();
+
+private:
+    /// Take a new slab and put its objects on the free list.
+    void Grow();
+
+    const char *name;
+    size_t objectSize;
+    unsigned objectsPerSlab;
+
+    /// Free objects, linked through their first word.
+    void *freeList;
+
+    unsigned long numAllocs;
+    unsigned long numFrees;
+    unsigned peakLive;
+    unsigned numSlabs;
+
+    /// Next cache, in order of creation.
+    SlabCache *next;
+
+    /// Every cache created, for the report.
+    static SlabCache *caches;
+};
+
+/// The cache for objects of class `T`, created the first time it is needed.
+template <class T>
+SlabCache *
+SlabCacheOf(const char *name)
+{
+    static SlabCache *cache = new SlabCache(name, sizeof (T));
+    return cache;
+}
+
+/// Declare it inside a class to allocate its objects from a cache of their
+/// own.  It leaves the declarations that follow it public.
+///
+/// Subclasses have to declare their own, since their objects are larger.
+#define SLAB_ALLOCATED(type)                                       \
+  public:                                                          \
+    static void *                                                  \
+    operator new(size_t size)                                      \
+    {                                                              \
+        ASSERT(size == sizeof (type));                             \
+        return SlabCacheOf<type>(#type)->Alloc();                  \
+    }                                                              \
+    static void                                                    \
+    operator delete(void *object)                                  \
+    {                                                              \
+        SlabCacheOf<type>(#type)->Free(object);                    \
+    }
+
+/// Return a buffer of at least `size` bytes.
+///
+/// Sizes up to `MAX_BUFFER_SIZE` come from the cache of the next power of
+/// two; larger ones straight from the heap.
+char *AllocBuffer(size_t size);
+
+/// Give back a buffer returned by `AllocBuffer(size)`.
+void FreeBuffer(char *buffer, size_t size);
+
+/// Largest buffer kept in a cache.
+const size_t MAX_BUFFER_SIZE = 4096;
+
+
+#endif
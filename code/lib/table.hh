@@ -1,5 +1,10 @@
 /// A very simple map from non-negative integers to some type.
 ///
+/// Occupied indexes are tracked in a bitmap, one bit per slot, so that
+/// looking an index up or freeing it takes constant time, and finding the
+/// lowest free index takes a scan of the bitmap a word at a time from the
+/// first word that may have room.  The table doubles in size when full.
+///
 /// Copyright (c) 2018-2021 Docentes de la Universidad Nacional de Rosario.
 /// All rights reserved.  See `copyright.h` for copyright notice and
 /// limitation of liability and disclaimer of warranty provisions.
@@ -8,18 +13,24 @@
 #define NACHOS_LIB_TABLE__HH
 
 
-#include "list.hh"
+#include "utility.hh"
 
 
 template <class T>
 class Table {
 public:
-    static const unsigned SIZE = 20;
+    /// Number of slots a table starts with.
+    static const unsigned INITIAL_SIZE = 32;
+
+    /// Largest number of slots a table can grow to.
+    static const unsigned MAX_SIZE = 1 << 16;
 
     /// Construct an empty table.
     Table();
 
-    /// Add an item into a free index.
+    ~Table();
+
+    /// Add an item into the lowest free index.
     ///
     /// Returns -1 if no space is left to add the item.
     int Add(T item);
@@ -46,45 +57,96 @@ public:
     /// Returns the old item.
     T Update(int i, T item);
 
+    /// Return a bound for the indexes in use: every index with an item is
+    /// below it.  Useful to go through the table.
+    unsigned GetCapacity() const;
+
 private:
+    /// Double the number of slots.
+    void Grow();
+
     /// Data items.
-    T data[SIZE];
+    T *data;
+
+    /// Number of slots in `data`.
+    unsigned capacity;
 
-    /// Current greatest index for a new item.
-    int current;
+    /// One bit per slot, set if the slot has an item.
+    unsigned *used;
 
-    /// A list to store indexes of items that have been freed and are not
-    /// among those with greatest numbers, so it is not possible to modify
-    /// `current`.  In other words, this keeps track of external
-    /// fragmentation.
-    List<int> freed;
+    /// Number of items.
+    unsigned count;
+
+    /// Every word of `used` below this one is full.
+    unsigned firstFree;
 };
 
 
 template <class T>
 Table<T>::Table()
 {
-    current = 0;
+    capacity = INITIAL_SIZE;
+    data = new T [capacity];
+    used = new unsigned [capacity / BITS_IN_WORD];
+    for (unsigned w = 0; w < capacity / BITS_IN_WORD; w++) {
+        used[w] = 0;
+    }
+    count = 0;
+    firstFree = 0;
 }
 
+template <class T>
+Table<T>::~Table()
+{
+    delete [] data;
+    delete [] used;
+}
+
+template <class T>
+void
+Table<T>::Grow()
+{
+    ASSERT(capacity < MAX_SIZE);
+
+    unsigned newCapacity = 2 * capacity;
+    T *newData = new T [newCapacity];
+    unsigned *newUsed = new unsigned [newCapacity / BITS_IN_WORD];
+    for (unsigned i = 0; i < capacity; i++) {
+        newData[i] = data[i];
+    }
+    for (unsigned w = 0; w < newCapacity / BITS_IN_WORD; w++) {
+        newUsed[w] = w < capacity / BITS_IN_WORD ? used[w] : 0;
+    }
+
+    delete [] data;
+    delete [] used;
+    data = newData;
+    used = newUsed;
+    capacity = newCapacity;
+}
 
 template <class T>
 int
 Table<T>::Add(T item)
 {
-    int i;
-
-    if (!freed.IsEmpty()) {
-        i = freed.Pop();
-        data[i] = item;
-        return i;
-    } else if (current < static_cast<int>(SIZE)) {
-        i = current++;
-        data[i] = item;
-        return i;
-    } else {
-        return -1;
+    if (count == capacity) {
+        if (capacity == MAX_SIZE) {
+            return -1;
+        }
+        Grow();
     }
+
+    unsigned w = firstFree;
+    while (used[w] == ~0u) {
+        w++;
+    }
+    firstFree = w;
+
+    int i = w * BITS_IN_WORD + __builtin_ctz(~used[w]);
+    used[w] |= 1u << i % BITS_IN_WORD;
+    data[i] = item;
+    count++;
+    return i;
 }
 
 template <class T>
@@ -102,14 +164,15 @@ Table<T>::HasKey(int i) const
 {
     ASSERT(i >= 0);
 
-    return i < current && !freed.Has(i);
+    return static_cast<unsigned>(i) < capacity
+           && used[i / BITS_IN_WORD] & 1u << i % BITS_IN_WORD;
 }
 
 template <class T>
 bool
 Table<T>::IsEmpty() const
 {
-    return current == 0;
+    return count == 0;
 }
 
 template <class T>
@@ -122,31 +185,35 @@ Table<T>::Remove(int i)
         return T();
     }
 
-    if (i == current - 1) {
-        current--;
-        for (int j = current - 1; j >= 0 && !HasKey(j); j--) {
-            ASSERT(freed.Has(j));
-            freed.SortedPop(&j);
-            current--;
-        }
-    } else {
-        freed.SortedInsert(i, i);
+    unsigned w = i / BITS_IN_WORD;
+    used[w] &= ~(1u << i % BITS_IN_WORD);
+    if (w < firstFree) {
+        firstFree = w;
     }
-    return data[i];
+    count--;
+
+    T item = data[i];
+    data[i] = T();
+    return item;
 }
 
 template <class T>
 T
 Table<T>::Update(int i, T item)
 {
-    ASSERT(i >= 0);
-    ASSERT(i < current);
-    ASSERT(!freed.Has(i));
+    ASSERT(HasKey(i));
 
     T previous = data[i];
     data[i] = item;
     return previous;
 }
 
+template <class T>
+unsigned
+Table<T>::GetCapacity() const
+{
+    return capacity;
+}
+
 
 #endif
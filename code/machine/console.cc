@@ -77,11 +77,13 @@ Console::Console(const char *readFile, const char *writeFile,
     // Start polling for incoming packets.
     interrupt->Schedule(ConsoleReadPoll, this,
                         CONSOLE_TIME, CONSOLE_READ_INT);
+    interrupt->WatchInput(readFileNo);
 }
 
 /// Clean up console emulation.
 Console::~Console()
 {
+    interrupt->UnwatchInput(readFileNo);
     if (readFileNo != 0) {
         SystemDep::Close(readFileNo);
     }
@@ -114,6 +116,7 @@ Console::CheckCharAvail()
     // Otherwise, read character and tell user about it.
     SystemDep::Read(readFileNo, &c, sizeof c);
     incoming = c;
+    interrupt->UnwatchInput(readFileNo);  // Until the kernel takes it.
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);
 }
@@ -135,6 +138,9 @@ Console::GetChar()
 {
     char ch = incoming;
 
+    if (ch != EOF) {
+        interrupt->WatchInput(readFileNo);
+    }
     incoming = EOF;
     return ch;
 }
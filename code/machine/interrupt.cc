@@ -25,13 +25,14 @@
 
 #include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 
 // String definitions for debugging messages
 
 static const char *INT_LEVEL_NAMES[] = { "disabled", "enabled" };
 static const char *INT_TYPE_NAMES[]  = {
-    "timer", "disk", "console write", "console read",
+    "timer", "alarm", "disk", "console write", "console read",
     "network send", "network recv"
 };
 
@@ -47,6 +48,9 @@ IsIntType(IntType t)
     return 0 <= t && t < NUM_INT_TYPES;
 }
 
+/// Room the heap of pending interrupts starts with.
+static const unsigned INITIAL_PENDING_CAPACITY = 16;
+
 /// Initialize a hardware device interrupt that is to be scheduled to occur
 /// in the near future.
 ///
@@ -64,6 +68,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
     arg     = param;
     when    = time;
     type    = kind;
+    seq     = 0;
 }
 
 /// Initialize the simulation of hardware device interrupts.
@@ -71,8 +76,17 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
 /// Interrupts start disabled, with no interrupts pending, etc.
 Interrupt::Interrupt()
 {
-    level         = INT_OFF;
-    pending       = new List<PendingInterrupt *>;
+    level           = INT_OFF;
+    pendingCapacity = INITIAL_PENDING_CAPACITY;
+    pending         = new PendingInterrupt *[pendingCapacity];
+    numPending      = 0;
+    nextSeq         = 0;
+    nextDue         = ULONG_MAX;
+    for (unsigned i = 0; i < NUM_INT_TYPES; i++) {
+        pendingOfType[i] = 0;
+    }
+    numInputs       = 0;
+    spare           = new PendingInterruptList;
     inHandler     = false;
     yieldOnReturn = false;
     status        = SYSTEM_MODE;
@@ -81,10 +95,14 @@ Interrupt::Interrupt()
 /// De-allocate the data structures needed by the interrupt simulation.
 Interrupt::~Interrupt()
 {
-    while (!pending->IsEmpty()) {
-        delete pending->Pop();
+    for (unsigned i = 0; i < numPending; i++) {
+        delete pending[i];
     }
-    delete pending;
+    delete [] pending;
+    while (!spare->IsEmpty()) {
+        delete spare->Pop();
+    }
+    delete spare;
 }
 
 /// Change interrupts to be enabled or disabled, without advancing the
@@ -158,11 +176,15 @@ Interrupt::OneTick()
     }
     DEBUG('i', "== Tick %u ==\n", stats->totalTicks);
 
-    // Check any pending interrupts are now ready to fire.
-    ChangeLevel(INT_ON, INT_OFF);  // First, turn off interrupts (interrupt
-                                   // handlers run with interrupts disabled).
-    while (CheckIfDue(false)) {}   // Check for pending interrupts.
-    ChangeLevel(INT_OFF, INT_ON);  // Re-enable interrupts.
+    // Check any pending interrupts are now ready to fire.  Most ticks none
+    // is, and then the pending interrupts are not even looked at.
+    if (stats->totalTicks >= nextDue) {
+        ChangeLevel(INT_ON, INT_OFF);  // First, turn off interrupts
+                                       // (interrupt handlers run with
+                                       // interrupts disabled).
+        while (CheckIfDue(false)) {}   // Check for pending interrupts.
+        ChangeLevel(INT_OFF, INT_ON);  // Re-enable interrupts.
+    }
     if (yieldOnReturn) {           // If the timer device handler asked for a
                                    // context switch, ok to do it now.
         yieldOnReturn = false;
@@ -198,6 +220,15 @@ Interrupt::Idle()
 {
     DEBUG('i', "Machine idling; checking for interrupts.\n");
     status = IDLE_MODE;
+
+    // If only input can make something happen, wait for it on the host
+    // rather than spinning through the polls.  Other interrupts are due at
+    // some simulated time, which is just skipped to.
+    if (OnlyPolling()) {
+        DEBUG('i', "Machine idle; waiting for input.\n");
+        stats->numIdleWaits++;
+        SystemDep::WaitForInput(inputFds, numInputs);
+    }
     if (CheckIfDue(true)) {           // Check for any pending interrupts.
         while (CheckIfDue(false)) {}  // Check for any other pending
                                       // interrupts.
@@ -210,7 +241,9 @@ Interrupt::Idle()
     // If there are no pending interrupts, and nothing is on the ready queue,
     // it is time to stop.  If the console or the network is operating, there
     // are *always* pending interrupts, so this code is not reached.
-    // Instead, the halt must be invoked by the user program.
+    // Instead, the halt must be invoked by the user program.  Neither is it
+    // while some thread sleeps on a timer, since the timer wheel keeps an
+    // interrupt pending.
 
     DEBUG('i', "Machine idle.  No interrupts to do.\n");
     printf("No threads ready or runnable, and no pending interrupts.\n");
@@ -224,11 +257,17 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    SlabCache::PrintAll();
+    stackPool->Print();
+    if (lockProfiler != nullptr) {
+        lockProfiler->Print();
+    }
     Cleanup();  // Never returns.
 }
 
 #ifdef DFS_TICKS_FIX
-/// Restart the total ticks statistic and the pending interrupts list.
+/// Restart the total ticks statistic and the times of the pending
+/// interrupts.
 ///
 /// This function makes sure Nachos keeps working even after overflowing the
 /// tick counter.  After some time (when `totalTicks` reach the maximum
@@ -237,19 +276,18 @@ Interrupt::Halt()
 void
 Interrupt::RestartTicks()
 {
-    List<PendingInterrupt *> *oldPending = pending;
-    pending = new List<PendingInterrupt *>;
-
-    PendingInterrupt *i;
-    unsigned          oldWhen = 0;
-    while ((i = oldPending->SortedPop((int *) &oldWhen)) != nullptr) {
-        unsigned newWhen = oldWhen - stats->totalTicks;
-        pending->SortedInsert(i, newWhen);
-        DEBUG('x', "Interrupt at time %u re-scheduled at new time %u.\n",
-              oldWhen, newWhen);
+    // Moving every interrupt back by the same time keeps the heap in order.
+    for (unsigned j = 0; j < numPending; j++) {
+        PendingInterrupt *i = pending[j];
+        unsigned long oldWhen = i->when;
+        i->when = oldWhen - stats->totalTicks;
+        DEBUG('x', "Interrupt at time %lu re-scheduled at new time %lu.\n",
+              oldWhen, i->when);
+    }
+    if (numPending > 0) {
+        nextDue = pending[0]->when;
     }
 
-    delete oldPending;
     stats->totalTicks = 0;
     stats->tickResets += 1;
 }
@@ -258,7 +296,9 @@ Interrupt::RestartTicks()
 /// Arrange for the CPU to be interrupted when simulated time reaches `now +
 /// when`.
 ///
-/// Implementation: just put it on a sorted list.
+/// Implementation: just put it on a heap sorted by time.  The interrupt is
+/// taken from the spare ones if there are any, so that once the devices are
+/// running, scheduling allocates nothing.
 ///
 /// NOTE: the Nachos kernel should not call this routine directly.  Instead,
 /// it is only called by the hardware device simulators.
@@ -287,14 +327,148 @@ Interrupt::Schedule(VoidFunctionPtr handler, void *arg,
     ASSERT(ULONG_MAX - stats->totalTicks > fromNow);
 #endif
 
-    unsigned when = stats->totalTicks + fromNow;
-    PendingInterrupt *toOccur = new PendingInterrupt(handler, arg,
-                                                     when, type);
+    unsigned long when = stats->totalTicks + fromNow;
+    PendingInterrupt *toOccur = spare->Pop();
+    if (toOccur == nullptr) {
+        toOccur = new PendingInterrupt(handler, arg, when, type);
+    } else {
+        toOccur->handler = handler;
+        toOccur->arg     = arg;
+        toOccur->when    = when;
+        toOccur->type    = type;
+    }
 
-    DEBUG('i', "Scheduling interrupt handler the %s at time = %u\n",
+    DEBUG('i', "Scheduling interrupt handler the %s at time = %lu\n",
           INT_TYPE_NAMES[type], when);
 
-    pending->SortedInsert(toOccur, when);
+    toOccur->seq = nextSeq++;
+    PushPending(toOccur);
+}
+
+void
+Interrupt::PushPending(PendingInterrupt *toOccur)
+{
+    if (numPending == pendingCapacity) {
+        PendingInterrupt **larger = new PendingInterrupt *[2 * pendingCapacity];
+        for (unsigned i = 0; i < numPending; i++) {
+            larger[i] = pending[i];
+        }
+        delete [] pending;
+        pending = larger;
+        pendingCapacity *= 2;
+    }
+    pending[numPending] = toOccur;
+    numPending++;
+    pendingOfType[toOccur->type]++;
+    SiftUp(numPending - 1);
+    nextDue = pending[0]->when;
+}
+
+PendingInterrupt *
+Interrupt::PopPending()
+{
+    ASSERT(numPending > 0);
+
+    PendingInterrupt *first = pending[0];
+    numPending--;
+    pendingOfType[first->type]--;
+    if (numPending > 0) {
+        pending[0] = pending[numPending];
+        SiftDown(0);
+        nextDue = pending[0]->when;
+    } else {
+        nextDue = ULONG_MAX;
+    }
+    return first;
+}
+
+void
+Interrupt::WatchInput(int fd)
+{
+    for (unsigned i = 0; i < numInputs; i++) {
+        if (inputFds[i] == fd) {
+            return;
+        }
+    }
+    ASSERT(numInputs < SystemDep::MAX_WAIT_FDS);
+    inputFds[numInputs++] = fd;
+}
+
+void
+Interrupt::UnwatchInput(int fd)
+{
+    for (unsigned i = 0; i < numInputs; i++) {
+        if (inputFds[i] == fd) {
+            inputFds[i] = inputFds[--numInputs];
+            return;
+        }
+    }
+}
+
+/// Periodic timers (for time slicing, random yields or sampling working
+/// sets) do nothing for an idle machine, unless some thread is suspended:
+/// sampling the working sets is what lets it run again.
+bool
+Interrupt::TimersIdle() const
+{
+#ifdef VMEM
+    return scheduler->FirstSuspended() == nullptr;
+#else
+    return true;
+#endif
+}
+
+/// Polling the console or the network does nothing until there is input;
+/// neither do the periodic timers while the machine is idle.
+bool
+Interrupt::OnlyPolling() const
+{
+    unsigned polls = pendingOfType[CONSOLE_READ_INT]
+                     + pendingOfType[NETWORK_RECV_INT];
+    return numInputs > 0 && polls > 0
+           && numPending == polls + pendingOfType[TIMER_INT]
+           && TimersIdle();
+}
+
+bool
+Interrupt::Before(unsigned i, unsigned j) const
+{
+    const PendingInterrupt *a = pending[i], *b = pending[j];
+    return a->when < b->when || (a->when == b->when && a->seq < b->seq);
+}
+
+void
+Interrupt::SiftUp(unsigned i)
+{
+    while (i > 0 && Before(i, (i - 1) / 2)) {
+        unsigned parent = (i - 1) / 2;
+        PendingInterrupt *p = pending[i];
+        pending[i] = pending[parent];
+        pending[parent] = p;
+        i = parent;
+    }
+}
+
+void
+Interrupt::SiftDown(unsigned i)
+{
+    for (;;) {
+        unsigned first = i;
+        unsigned left = 2 * i + 1, right = 2 * i + 2;
+        if (left < numPending && Before(left, first)) {
+            first = left;
+        }
+        if (right < numPending && Before(right, first)) {
+            first = right;
+        }
+        if (first == i) {
+            return;
+        }
+        PendingInterrupt *p = pending[i];
+        pending[i] = pending[first];
+        pending[first] = p;
+        i = first;
+    }
 }
 
 /// Check if an interrupt is scheduled to occur, and if so, fire it off.
@@ -309,35 +483,34 @@ bool
 Interrupt::CheckIfDue(bool advanceClock)
 {
     MachineStatus old = status;
-    unsigned      when;
 
     ASSERT(level == INT_OFF);  // Interrupts need to be disabled, to invoke
                                // an interrupt handler.
     if (debug.IsEnabled('i')) {
         DumpState();
     }
-    PendingInterrupt *toOccur = pending->SortedPop((int *) &when);
-
-    if (toOccur == nullptr) {  // No pending interrupts.
+    if (numPending == 0) {  // No pending interrupts.
         return false;
     }
 
+    PendingInterrupt *toOccur = pending[0];
+    unsigned long     when    = toOccur->when;
     if (advanceClock && when > stats->totalTicks) {  // Advance the clock.
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {  // Not time yet, put it back.
-        pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks) {  // Not time yet, leave it.
         return false;
     }
 
-    // Check if there is nothing more to do, and if so, quit.
-    if (status == IDLE_MODE && toOccur->type == TIMER_INT
-          && pending->IsEmpty()) {
-        pending->SortedInsert(toOccur, when);
+    // Check if there is nothing more to do, and if so, quit.  There may
+    // be more than one periodic timer.
+    if (status == IDLE_MODE && numPending == pendingOfType[TIMER_INT]
+          && TimersIdle()) {
         return false;
     }
+    PopPending();
 
-    DEBUG('i', "Invoking interrupt handler for the %s at time %u\n",
+    DEBUG('i', "Invoking interrupt handler for the %s at time %lu\n",
             INT_TYPE_NAMES[toOccur->type], toOccur->when);
 #ifdef USER_PROGRAM
     if (machine != nullptr) {
@@ -350,7 +523,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     (*toOccur->handler)(toOccur->arg);  // Call the interrupt handler.
     status = old;  // Restore the machine status.
     inHandler = false;
-    delete toOccur;
+    spare->Append(toOccur);
     return true;
 }
 
@@ -383,6 +556,18 @@ PrintPending(PendingInterrupt *pend)
            INT_TYPE_NAMES[pend->type], pend->when);
 }
 
+/// Order of pending interrupts, for `qsort`.
+static int
+ComparePending(const void *a, const void *b)
+{
+    const PendingInterrupt *x = *(PendingInterrupt * const *) a;
+    const PendingInterrupt *y = *(PendingInterrupt * const *) b;
+    if (x->when != y->when) {
+        return x->when < y->when ? -1 : 1;
+    }
+    return x->seq < y->seq ? -1 : x->seq > y->seq;
+}
+
 /// Print the complete interrupt state -- the status, and all interrupts that
 /// are scheduled to occur in the future.
 void
@@ -390,10 +575,19 @@ Interrupt::DumpState()
 {
     printf("Time: %lu, interrupts %s\n",
            stats->totalTicks, INT_LEVEL_NAMES[level]);
-    if (pending->IsEmpty()) {
+    if (numPending == 0) {
         printf("No pending interrupts\n");
     } else {
+        // The heap is only partly sorted; print them in order.
+        PendingInterrupt **sorted = new PendingInterrupt *[numPending];
+        for (unsigned i = 0; i < numPending; i++) {
+            sorted[i] = pending[i];
+        }
+        qsort(sorted, numPending, sizeof *sorted, ComparePending);
         printf("Pending interrupts:\n");
-        pending->Apply(PrintPending);
+        for (unsigned i = 0; i < numPending; i++) {
+            PrintPending(sorted[i]);
+        }
+        delete [] sorted;
     }
 }
@@ -36,7 +36,9 @@
 #define NACHOS_MACHINE_INTERRUPT__HH
 
 
-#include "lib/list.hh"
+#include "lib/intrusive_list.hh"
+#include "lib/slab.hh"
+#include "system_dep.hh"
 
 
 /// Interrupts can be disabled (`INT_OFF`) or enabled (`INT_ON`).
@@ -59,8 +61,13 @@ enum MachineStatus {
 /// `IntType` records which hardware device generated an interrupt.  In
 /// Nachos, we support a hardware timer device, a disk, a console display and
 /// keyboard, and a network.
+///
+/// The timer also has a one-shot alarm, which the kernel sets while some
+/// thread waits on a timer.  Unlike the periodic interrupt, a pending alarm
+/// keeps an idle machine from halting.
 enum IntType {
     TIMER_INT,
+    ALARM_INT,
     DISK_INT,
     CONSOLE_WRITE_INT,
     CONSOLE_READ_INT,
@@ -76,6 +83,7 @@ enum IntType {
 /// manipulate.
 class PendingInterrupt {
 public:
+    SLAB_ALLOCATED(PendingInterrupt)
 
     /// initialize an interrupt that will occur in the future.
     PendingInterrupt(VoidFunctionPtr func, void *param,
@@ -87,8 +95,15 @@ public:
     void *arg;  ///< The argument to the function.
     unsigned long when;  ///< When the interrupt is supposed to fire.
     IntType type;  ///< For debugging.
+    unsigned long seq;  ///< Order of scheduling, so that interrupts due at
+                        ///< the same time occur in that order.
+    ListLink<PendingInterrupt> link;  ///< On the list of spare
+                                      ///< interrupts.
 };
 
+typedef IntrusiveList<PendingInterrupt, &PendingInterrupt::link>
+  PendingInterruptList;
+
 /// The following class defines the data structures for the simulation
 /// of hardware interrupts.
 ///
@@ -145,10 +160,35 @@ public:
     /// Advance simulated time.
     void OneTick();
 
+    /// Have `Idle` block on the host until there is something to read on
+    /// `fd`, when polling for input is all that the devices are doing.
+    ///
+    /// This is called by the devices that poll a host file.
+    void WatchInput(int fd);
+
+    /// Stop waiting on `fd`, for instance while the device has input
+    /// buffered already.
+    void UnwatchInput(int fd);
+
 private:
     IntStatus level;  ///< Are interrupts enabled or disabled?
-    List<PendingInterrupt *> *pending;  ///< The list of interrupts scheduled
-                                        ///< to occur in the future.
+    PendingInterrupt **pending;  ///< The interrupts scheduled to occur in
+                                 ///< the future, in a binary min-heap by
+                                 ///< time.
+    unsigned numPending;  ///< Interrupts in `pending`.
+    unsigned pendingCapacity;  ///< Room in `pending`; it only grows.
+    unsigned long nextSeq;  ///< Order of the next interrupt scheduled.
+    unsigned long nextDue;  ///< When the first pending interrupt occurs,
+                            ///< `ULONG_MAX` if none.  Until then, ticks
+                            ///< do not look at the pending interrupts.
+    unsigned pendingOfType[NUM_INT_TYPES];  ///< Pending interrupts of each
+                                            ///< type.
+    int inputFds[SystemDep::MAX_WAIT_FDS];  ///< Host files the devices poll
+                                            ///< for input.
+    unsigned numInputs;  ///< Files in `inputFds`.
+    PendingInterruptList *spare;  ///< Interrupts that already occurred,
+                                  ///< kept to schedule new ones without
+                                  ///< allocating them.
     bool inHandler;  ///< True if we are running an interrupt handler.
     bool yieldOnReturn;  ///< True if we are to context switch on return from
                          ///< the interrupt handler.
@@ -163,6 +203,26 @@ private:
     void ChangeLevel(IntStatus old,
                      IntStatus now);
 
+    /// Put an interrupt on the heap of pending ones.
+    void PushPending(PendingInterrupt *toOccur);
+
+    /// Take the first interrupt off the heap of pending ones.
+    PendingInterrupt *PopPending();
+
+    /// Whether the periodic timers can make nothing happen while the
+    /// machine is idle.
+    bool TimersIdle() const;
+
+    /// Whether nothing is pending but polling for input and the periodic
+    /// timers, so that nothing happens until some input arrives.
+    bool OnlyPolling() const;
+
+    /// Whether the pending interrupt at `i` occurs before the one at `j`.
+    bool Before(unsigned i, unsigned j) const;
+
+    void SiftUp(unsigned i);
+    void SiftDown(unsigned i);
+
 #ifdef DFS_TICKS_FIX
     /// Restart total ticks and the pending interrupt list.
     void RestartTicks();
@@ -45,11 +45,14 @@ CheckEndian()
 /// * `st` -- pointer to an object that performs single stepping, for
 ///   dropping into it after each user instruction is executed; if null,
 ///   execute normally, without single stepping.
-Machine::Machine(SingleStepper *st)
+/// * `numPhysPages` -- size of the physical memory, in pages.
+Machine::Machine(SingleStepper *st, unsigned numPhysPages)
+    : mmu(numPhysPages)
 {
     for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
-        registers[i] = 0;
+        ownRegisters[i] = 0;
     }
+    registers = ownRegisters;
 
     for (unsigned i = 0; i < NUM_EXCEPTION_TYPES; i++) {
         handlers[i] = nullptr;
@@ -65,6 +68,12 @@ Machine::GetRegisters() const
     return registers;
 }
 
+void
+Machine::SetRegisterFile(int *file)
+{
+    registers = file != nullptr ? file : ownRegisters;
+}
+
 MMU *
 Machine::GetMMU()
 {
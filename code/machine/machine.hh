@@ -68,7 +68,8 @@ class Machine {
 public:
 
     /// Initialize the simulation of the hardware for running user programs.
-    Machine(SingleStepper *st);
+    Machine(SingleStepper *st,
+            unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES);
 
     /// Routines callable by the Nachos kernel.
 
@@ -77,6 +78,15 @@ public:
 
     const int *GetRegisters() const;
 
+    /// Use `file`, an array of `NUM_TOTAL_REGS`, as the CPU registers from
+    /// now on, without copying anything; null goes back to the registers
+    /// of the machine itself.
+    ///
+    /// Every thread running a user program keeps its registers in a file
+    /// of its own, so that a context switch only has to change the file in
+    /// use.
+    void SetRegisterFile(int *file);
+
     MMU *GetMMU();
 
     /// Read the contents of a CPU register.
@@ -126,8 +136,11 @@ private:
                                    ///< after each simulated instruction.
 
     /// Private data structures.
-    int registers[NUM_TOTAL_REGS];  ///< CPU registers, for executing user
-                                    ///< programs.
+    int *registers;  ///< CPU registers, for executing user programs; the
+                     ///< register file in use.
+
+    /// Registers used when no thread has given its own.
+    int ownRegisters[NUM_TOTAL_REGS];
 
     MMU mmu; ///< Memory management unit.
 
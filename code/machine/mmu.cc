@@ -30,16 +30,23 @@
 
 #include "mmu.hh"
 #include "endianness.hh"
+#include "system_dep.hh"
 
 #include <stdio.h>
 
 
-MMU::MMU()
+MMU::MMU(unsigned numPhysPages_)
 {
-    mainMemory = new char [MEMORY_SIZE];
-    for (unsigned i = 0; i < MEMORY_SIZE; i++) {
-        mainMemory[i] = 0;
-    }
+    ASSERT(numPhysPages_ > 0 && numPhysPages_ <= MAX_NUM_PHYS_PAGES);
+
+    numPhysPages = numPhysPages_;
+    memorySize = (size_t) numPhysPages * PAGE_SIZE;
+    mainMemory = SystemDep::AllocZeroedMemory(memorySize);
+
+    asid = 0;
+    traceFile = -1;
+    traceBuffer = nullptr;
+    traceCount = 0;
 
 #ifdef USE_TLB
     tlb = new TranslationEntry[TLB_SIZE];
@@ -55,7 +62,8 @@ MMU::MMU()
 
 MMU::~MMU()
 {
-    delete [] mainMemory;
+    StopTrace();
+    SystemDep::DeallocZeroedMemory(mainMemory, memorySize);
     if (tlb != nullptr) {
         delete [] tlb;
     }
@@ -262,8 +270,8 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr,
 
     // If the `pageFrame` is too big, there is something really wrong!  An
     // invalid translation was loaded into the page table or TLB.
-    if (pageFrame >= NUM_PHYS_PAGES) {
-        DEBUG_CONT('a', "frame %u > %u!\n", pageFrame, NUM_PHYS_PAGES);
+    if (pageFrame >= numPhysPages) {
+        DEBUG_CONT('a', "frame %u > %u!\n", pageFrame, numPhysPages);
         return BUS_ERROR_EXCEPTION;
     }
 
@@ -274,7 +282,72 @@ MMU::Translate(unsigned virtAddr, unsigned *physAddr,
     }
 
     *physAddr = pageFrame * PAGE_SIZE + offset;
-    ASSERT(*physAddr >= 0 && *physAddr + size <= MEMORY_SIZE);
+    ASSERT(*physAddr >= 0 && *physAddr + size <= memorySize);
     DEBUG_CONT('a', "physical address 0x%X\n", *physAddr);
+    if (traceFile != -1) {
+        TraceAccess(vpn, writing);
+    }
     return NO_EXCEPTION;
 }
+
+void
+MMU::StartTrace(const char *path)
+{
+    ASSERT(path != nullptr);
+    ASSERT(traceFile == -1);
+
+    traceFile = SystemDep::OpenForWrite(path);
+    mmuTraceHeader header;
+    header.magic = MMU_TRACE_MAGIC;
+    header.pageSize = PAGE_SIZE;
+    SystemDep::WriteFile(traceFile, (const char *) &header, sizeof header);
+
+    traceBuffer = new mmuTraceRecord [TRACE_BUFFER_SIZE];
+    traceCount = 0;
+    pendingRecord.count = 0;
+}
+
+void
+MMU::StopTrace()
+{
+    if (traceFile == -1) {
+        return;
+    }
+    FlushTrace(true);
+    SystemDep::Close(traceFile);
+    traceFile = -1;
+    delete [] traceBuffer;
+    traceBuffer = nullptr;
+}
+
+void
+MMU::TraceAccess(unsigned vpn, bool writing)
+{
+    uint16_t kind = writing ? MMU_TRACE_WRITE : 0;
+    unsigned run = pendingRecord.count & MMU_TRACE_MAX_COUNT;
+    if (run > 0 && run < MMU_TRACE_MAX_COUNT && pendingRecord.vpn == vpn
+          && pendingRecord.asid == asid
+          && (pendingRecord.count & MMU_TRACE_WRITE) == kind) {
+        pendingRecord.count++;
+        return;
+    }
+
+    FlushTrace(false);
+    pendingRecord.vpn = vpn;
+    pendingRecord.asid = asid;
+    pendingRecord.count = kind | 1;
+}
+
+void
+MMU::FlushTrace(bool all)
+{
+    if ((pendingRecord.count & MMU_TRACE_MAX_COUNT) != 0) {
+        traceBuffer[traceCount++] = pendingRecord;
+        pendingRecord.count = 0;
+    }
+    if (traceCount > 0 && (all || traceCount == TRACE_BUFFER_SIZE)) {
+        SystemDep::WriteFile(traceFile, (const char *) traceBuffer,
+                             traceCount * sizeof *traceBuffer);
+        traceCount = 0;
+    }
+}
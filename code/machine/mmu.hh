@@ -12,6 +12,9 @@
 #include "exception_type.hh"
 #include "disk.hh"
 #include "translation_entry.hh"
+#include "bin/mmu_trace.h"
+
+#include <stddef.h>
 
 
 /// Definitions related to the size, and format of user memory.
@@ -19,8 +22,13 @@
 const unsigned PAGE_SIZE = SECTOR_SIZE;  ///< Set the page size equal to the
                                          ///< disk sector size, for
                                          ///< simplicity.
-const unsigned NUM_PHYS_PAGES = 256;
-const unsigned MEMORY_SIZE = NUM_PHYS_PAGES * PAGE_SIZE;
+
+/// Number of physical pages, unless another one is given at startup.
+const unsigned DEFAULT_NUM_PHYS_PAGES = 256;
+
+/// Largest number of physical pages, so that physical addresses fit in 32
+/// bits.
+const unsigned MAX_NUM_PHYS_PAGES = 0xFFFFFFFF / PAGE_SIZE;
 
 /// Number of entries in the TLB, if one is present.
 ///
@@ -32,8 +40,8 @@ const unsigned TLB_SIZE = 4;
 /// page tables or a TLB.
 class MMU {
 public:
-    // Initialize the MMU subsystem.
-    MMU();
+    // Initialize the MMU subsystem, with `numPhysPages` pages of memory.
+    MMU(unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES);
 
     // Deallocate data structures.
     ~MMU();
@@ -47,6 +55,12 @@ public:
 
     void PrintTLB() const;
 
+    /// Write a record of every successful translation to the host file
+    /// `path`, until `StopTrace` is called.
+    void StartTrace(const char *path);
+
+    void StopTrace();
+
     /// Data structures -- all of these are accessible to Nachos kernel code.
     /// “Public” for convenience.
     ///
@@ -57,6 +71,9 @@ public:
     char *mainMemory;  ///< Physical memory to store user program,
                        ///< code and data, while executing.
 
+    unsigned numPhysPages;  ///< Size of `mainMemory`, in pages and in
+    size_t memorySize;      ///< bytes.
+
     /// NOTE: the hardware translation of virtual addresses in the user
     /// program to physical addresses (relative to the beginning of
     /// `mainMemory`) can be controlled by one of:
@@ -82,8 +99,31 @@ public:
     TranslationEntry *pageTable;
     unsigned pageTableSize;
 
+    /// Identifier of the address space being translated, for the trace.
+    /// Kept up to date by the kernel.
+    unsigned asid;
+
 private:
 
+    /// Number of trace records written to the host at once.
+    static const unsigned TRACE_BUFFER_SIZE = 4096;
+
+    /// Add an access to the trace.
+    void TraceAccess(unsigned vpn, bool writing);
+
+    /// Move the pending trace record to the buffer, and the buffer to the
+    /// host file if it is full or `all` is set.
+    void FlushTrace(bool all);
+
+    /// Host file receiving the trace, or -1 if not tracing.
+    int traceFile;
+
+    mmuTraceRecord *traceBuffer;
+    unsigned traceCount;
+
+    /// Run of accesses not yet recorded in `traceBuffer`.
+    mmuTraceRecord pendingRecord;
+
     /// Retrieve a page entry either from a page table or the TLB.
     ExceptionType RetrievePageEntry(unsigned vpn,
                                     TranslationEntry **entry) const;
@@ -65,10 +65,12 @@ Network::Network(NetworkAddress addr, double reliability,
     // Start polling for incoming packets.
     interrupt->Schedule(NetworkReadPoll, this,
                         NETWORK_TIME, NETWORK_RECV_INT);
+    interrupt->WatchInput(sock);
 }
 
 Network::~Network()
 {
+    interrupt->UnwatchInput(sock);
     SystemDep::CloseSocket(sock);
     SystemDep::DeAssignNameToSocket(sockName);
 }
@@ -99,6 +101,7 @@ Network::CheckPktAvail()
     ASSERT(inHdr.to == ident && inHdr.length <= MAX_PACKET_SIZE);
     memcpy(inbox, buffer + sizeof (PacketHeader), inHdr.length);
     delete [] buffer;
+    interrupt->UnwatchInput(sock);  // Until the kernel takes it.
 
     DEBUG('n', "Network received packet from %d, length %u...\n",
           (int) inHdr.from, inHdr.length);
@@ -163,6 +166,7 @@ Network::Receive(char *data)
     inHdr.length = 0;
     if (hdr.length != 0) {
         memmove(data, inbox, hdr.length);
+        interrupt->WatchInput(sock);
     }
     return hdr;
 }
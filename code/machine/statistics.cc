@@ -20,7 +20,15 @@ Statistics::Statistics()
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
+    numIdleWaits = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
+    numPagesSwappedIn = numPagesSwappedOut = numSuspensions = 0;
+    numSwapReads = numSwapWrites = 0;
+    numPrefetchUseful = numPrefetchWasted = 0;
+    numCacheStores = numCacheRejects = numCacheHits = numCacheMisses = 0;
+    cacheBytesIn = cacheBytesOut = numCacheWritesAvoided = 0;
+    numMergedFrames = numCowBreaks = 0;
+    numRealTimeJobs = numDeadlinesMissed = numBudgetOverruns = 0;
 #ifdef DFS_TICKS_FIX
     tickResets = 0;
 #endif
@@ -43,7 +51,36 @@ Statistics::Print()
     printf("Disk I/O: reads %lu, writes %lu\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %lu, writes %lu\n",
            numConsoleCharsRead, numConsoleCharsWritten);
+    if (numIdleWaits != 0) {
+        printf("Idle: waits for input %lu\n", numIdleWaits);
+    }
     printf("Paging: faults %lu\n", numPageFaults);
+    if (numPagesSwappedIn != 0 || numPagesSwappedOut != 0) {
+        printf("Swap: pages in %lu (%lu reads), out %lu (%lu writes), "
+               "suspensions %lu\n",
+               numPagesSwappedIn, numSwapReads,
+               numPagesSwappedOut, numSwapWrites, numSuspensions);
+        printf("Read-around: useful pages %lu, wasted %lu\n",
+               numPrefetchUseful, numPrefetchWasted);
+    }
+    if (numCacheStores != 0 || numCacheRejects != 0) {
+        unsigned long lookups = numCacheHits + numCacheMisses;
+        printf("Compressed cache: stores %lu (%lu rejected), hits %lu of %lu"
+               " (%lu%%), ratio %lu%%, writes avoided %lu\n",
+               numCacheStores, numCacheRejects, numCacheHits, lookups,
+               lookups != 0 ? numCacheHits * 100 / lookups : 0,
+               cacheBytesIn != 0 ? cacheBytesOut * 100 / cacheBytesIn : 0,
+               numCacheWritesAvoided);
+    }
+    if (numMergedFrames != 0) {
+        printf("Deduplication: merged frames %lu, copy-on-write breaks %lu\n",
+               numMergedFrames, numCowBreaks);
+    }
+    if (numRealTimeJobs != 0 || numBudgetOverruns != 0) {
+        printf("Real time: jobs %lu, deadlines missed %lu, "
+               "budget overruns %lu\n",
+               numRealTimeJobs, numDeadlinesMissed, numBudgetOverruns);
+    }
     printf("Network I/O: packets received %lu, sent %lu\n",
            numPacketsRecvd, numPacketsSent);
 }
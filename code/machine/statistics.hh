@@ -44,9 +44,64 @@ public:
     /// Number of characters written to the display.
     unsigned long numConsoleCharsWritten;
 
+    /// Number of times the idle machine blocked on the host until some
+    /// input arrived.
+    unsigned long numIdleWaits;
+
     /// Number of virtual memory page faults.
     unsigned long numPageFaults;
 
+    /// Number of pages read from swap.
+    unsigned long numPagesSwappedIn;
+
+    /// Number of pages written to swap.
+    unsigned long numPagesSwappedOut;
+
+    /// Number of transfers from and to swap; each one may move several
+    /// pages.
+    unsigned long numSwapReads;
+    unsigned long numSwapWrites;
+
+    /// Number of pages read around a fault that were later referenced, and
+    /// that were not.
+    unsigned long numPrefetchUseful;
+    unsigned long numPrefetchWasted;
+
+    /// Number of times a process was suspended because the working sets
+    /// did not fit in memory.
+    unsigned long numSuspensions;
+
+    /// Number of evicted pages kept in the compressed cache, and of those
+    /// that did not compress well enough.
+    unsigned long numCacheStores;
+    unsigned long numCacheRejects;
+
+    /// Number of faults on swapped pages served from the compressed cache,
+    /// and from the swap file.
+    unsigned long numCacheHits;
+    unsigned long numCacheMisses;
+
+    /// Bytes given to the compressed cache, and bytes it kept.
+    unsigned long cacheBytesIn;
+    unsigned long cacheBytesOut;
+
+    /// Number of dirty pages dropped from the compressed cache, along with
+    /// their address space, without ever being written to swap.
+    unsigned long numCacheWritesAvoided;
+
+    /// Number of frames freed by merging pages with identical contents.
+    unsigned long numMergedFrames;
+
+    /// Number of writes to merged pages that required a private copy.
+    unsigned long numCowBreaks;
+
+    /// Number of jobs done by real-time threads, of those that were done
+    /// after their deadline, and of periods in which a real-time thread
+    /// ran out of budget.
+    unsigned long numRealTimeJobs;
+    unsigned long numDeadlinesMissed;
+    unsigned long numBudgetOverruns;
+
     /// Number of packets sent over the network.
     unsigned long numPacketsSent;
 
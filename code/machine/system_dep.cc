@@ -36,6 +36,8 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
+#include <errno.h>
+#include <poll.h>
 #ifdef HOST_i386
 #include <sys/time.h>
 #endif
@@ -96,6 +98,27 @@ PollFile(int fd)
     return retVal;  // If 0, no char waiting to be read.
 }
 
+/// Used when the machine is idle and only waiting for input, so that it
+/// takes no host CPU meanwhile.  A hang up counts as something to read, so
+/// that the device finds out.
+bool
+WaitForInput(const int *fds, unsigned numFds)
+{
+    ASSERT(fds != nullptr);
+    ASSERT(numFds > 0 && numFds <= MAX_WAIT_FDS);
+
+    struct pollfd pfds[MAX_WAIT_FDS];
+    for (unsigned i = 0; i < numFds; i++) {
+        pfds[i].fd = fds[i];
+        pfds[i].events = POLLIN;
+        pfds[i].revents = 0;
+    }
+
+    int retVal = poll(pfds, numFds, -1);  // No timeout.
+    ASSERT(retVal > 0 || errno == EINTR);
+    return retVal > 0;
+}
+
 /// Open a file for writing.
 ///
 /// Create it if it does not exist; truncate it if it does already exist.
@@ -395,4 +418,32 @@ DeallocBoundedArray(const char *ptr, unsigned size)
     delete [] (ptr - pgSize);
 }
 
+/// Return `size` bytes of anonymous memory, filled with zeros.
+///
+/// The host maps its pages lazily, so memory that is never touched costs
+/// nothing and there is no need to clear it.
+char *
+AllocZeroedMemory(size_t size)
+{
+    ASSERT(size > 0);
+
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    ASSERT(ptr != MAP_FAILED);
+    return (char *) ptr;
+}
+
+/// Give memory obtained from `AllocZeroedMemory` back to the host.
+void
+DeallocZeroedMemory(char *ptr, size_t size)
+{
+    ASSERT(ptr != nullptr);
+    ASSERT(size > 0);
+
+    munmap(ptr, size);
+}
+
 };
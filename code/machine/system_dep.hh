@@ -22,6 +22,15 @@ namespace SystemDep {
     /// If no characters in the file, return without waiting.
     bool PollFile(int fd);
 
+    /// Block until there is something to read on any of the `numFds`
+    /// files in `fds`, or a signal arrives.
+    ///
+    /// Return whether some file is ready.
+    bool WaitForInput(const int *fds, unsigned numFds);
+
+    /// Most files `WaitForInput` can wait on at a time.
+    const unsigned MAX_WAIT_FDS = 8;
+
     /// File operations: `open`/`read`/`write`/`lseek`/`close`, and check for
     /// error.
     ///
@@ -81,6 +90,15 @@ namespace SystemDep {
     char *AllocBoundedArray(unsigned size);
 
     void DeallocBoundedArray(const char *p, unsigned size);
+
+    /// Allocate, de-allocate zero-filled memory straight from the host.
+    ///
+    /// Only the host pages actually touched take up space, so the memory
+    /// may be much larger than what is used of it.
+
+    char *AllocZeroedMemory(size_t size);
+
+    void DeallocZeroedMemory(char *p, size_t size);
 };
 
 
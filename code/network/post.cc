@@ -249,8 +249,9 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, const char *data)
 {
     ASSERT(data != nullptr);
 
-    char *buffer = new char [MAX_PACKET_SIZE];  // Space to hold concatenated
-                                                // `mailHdr` + data.
+    char *buffer = AllocBuffer(MAX_PACKET_SIZE);  // Space to hold
+                                                  // concatenated `mailHdr`
+                                                  // + data.
 
     if (debug.IsEnabled('n')) {
         printf("Post send: ");
@@ -274,8 +275,8 @@ PostOffice::Send(PacketHeader pktHdr, MailHeader mailHdr, const char *data)
                        // message.
     sendLock->Release();
 
-    delete [] buffer;  // We have sent the message, so we can delete our
-                       // buffer.
+    FreeBuffer(buffer, MAX_PACKET_SIZE);  // We have sent the message, so we
+                                          // can give our buffer back.
 }
 
 /// Retrieve a message from a specific box if one is available, otherwise
@@ -30,6 +30,7 @@
 #include "network.hh"
 #include "threads/semaphore.hh"
 #include "threads/synch_list.hh"
+#include "lib/slab.hh"
 
 
 /// Mailbox address -- uniquely identifies a mailbox on a given machine.
@@ -62,6 +63,7 @@ const unsigned MAX_MAIL_SIZE = MAX_PACKET_SIZE - sizeof (MailHeader);
 /// 3. data.
 class Mail {
 public:
+    SLAB_ALLOCATED(Mail)
 
     /// Initialize a mail message by concatenating the headers to the data.
     Mail(PacketHeader pktH, MailHeader mailH, const char *msgData);
@@ -0,0 +1,40 @@
+#!/bin/bash
+# Quick checks on the Nachos binaries that have been built.
+#
+# Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+# All rights reserved.  See `copyright.h` for copyright notice and
+# limitation of liability and disclaimer of warranty provisions.
+
+cd "$(dirname "$0")/.." || exit 1
+
+# Seconds a run may take before it is taken to hang.
+TIMEOUT=20
+
+failed=0
+
+# Check that `nachos` in directory `$1`, run with the rest of the arguments,
+# halts on its own.
+halts() {
+    local dir=$1
+    shift
+    if [ ! -x "$dir/nachos" ]; then
+        echo "SKIP  $dir/nachos $* (not built)"
+        return
+    fi
+    if (cd "$dir" && timeout $TIMEOUT ./nachos "$@" </dev/null 2>&1) \
+         | grep -q "Machine halting!"; then
+        echo "OK    $dir/nachos $*"
+    else
+        echo "FAIL  $dir/nachos $* does not halt"
+        failed=1
+    fi
+}
+
+# An idle machine halts even with periodic timers pending: the one for
+# random yields, and in *VMEM* the one that samples working sets.
+for dir in threads userprog vmem; do
+    halts $dir
+    halts $dir -rs 1
+done
+
+exit $failed
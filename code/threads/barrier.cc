@@ -0,0 +1,58 @@
+/// Routines for barriers.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "barrier.hh"
+
+Barrier::Barrier(const char *debugName, unsigned count_)
+{
+    ASSERT(count_ > 0);
+
+    name = debugName;
+    count = count_;
+    waiting = new ThreadQueue;
+    numWaiting = 0;
+}
+
+Barrier::~Barrier()
+{
+    ASSERT(numWaiting == 0);
+    delete waiting;
+}
+
+const char *
+Barrier::GetName() const
+{
+    return name;
+}
+
+/// The last thread empties the queue before going on, so the next round
+/// starts afresh even if none of the others has run yet.
+bool
+Barrier::Wait()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    bool last = numWaiting + 1 == count;
+    if (last)
+    {
+        DEBUG('t', "Barrier %s opens for %u threads\n", name, count);
+        Thread *t;
+        while ((t = scheduler->PopWaiter(waiting)) != nullptr)
+        {
+            scheduler->ReadyToRun(t);
+        }
+        numWaiting = 0;
+    }
+    else
+    {
+        numWaiting++;
+        waiting->Append(currentThread);
+        currentThread->Sleep();
+    }
+
+    interrupt->SetLevel(oldLevel);
+    return last;
+}
@@ -0,0 +1,52 @@
+/// Barrier, a synchronization primitive
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_BARRIER__HH
+#define NACHOS_THREADS_BARRIER__HH
+
+#include "thread.hh"
+#include "system.hh"
+
+/// This class defines a “barrier”.
+///
+/// A barrier is set up for a number of threads, and has a single
+/// operation:
+///
+/// * `Wait` -- block until that many threads have called it; then all of
+///   them go on, and the barrier is ready for the next round.
+///
+/// A thread that comes back for the next round before the others have
+/// left the last one just waits for the next round.
+class Barrier
+{
+public:
+    /// Constructor: set up the barrier for `count` threads.
+    Barrier(const char *debugName, unsigned count);
+
+    /// No thread may be waiting.
+    ~Barrier();
+
+    /// For debugging.
+    const char *GetName() const;
+
+    /// Returns `true` in the last thread to arrive, and `false` in the
+    /// others, so that a single one of them can do some work for the
+    /// round.
+    bool Wait();
+
+private:
+    /// For debugging.
+    const char *name;
+
+    /// Threads that make up a round.
+    unsigned count;
+
+    /// Threads blocked in the current round.
+    ThreadQueue *waiting;
+    unsigned numWaiting;
+};
+
+#endif
@@ -62,6 +62,26 @@ void Condition::Wait()
     conditionLock->Acquire();
 }
 
+bool Condition::Wait(unsigned long timeout)
+{
+    waiting++;
+
+    conditionLock->Release();
+
+    // A waiter that times out has to leave the count before anybody else
+    // signals, or the signal would be lost on it.
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    bool signalled = signal->P(timeout);
+    if (!signalled)
+    {
+        waiting--;
+    }
+    interrupt->SetLevel(oldLevel);
+
+    conditionLock->Acquire();
+    return signalled;
+}
+
 void Condition::Signal()
 {
     ASSERT(conditionLock->IsHeldByCurrentThread());
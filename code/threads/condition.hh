@@ -70,6 +70,12 @@ public:
     void Signal();
     void Broadcast();
 
+    /// Like `Wait`, but give up once `timeout` ticks have gone by.  The
+    /// lock is held again on return either way.
+    ///
+    /// Returns whether the thread was signalled.
+    bool Wait(unsigned long timeout);
+
 private:
 
     const char *name;
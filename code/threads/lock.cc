@@ -23,16 +23,17 @@
 Lock::Lock(const char *debugName)
 {
     name = debugName;
-    semName = new char[strlen(debugName) + 16];
-    sprintf(semName, "LockSemaphore::%s", debugName);
-    semaphore = new Semaphore(semName, 1);
     owner = nullptr;
+    waiters = new ThreadQueue;
+    nextHeld = nullptr;
+    profile = lockProfiler != nullptr ? lockProfiler->Find(debugName)
+                                      : nullptr;
+    acquiredAt = 0;
 }
 
 Lock::~Lock()
 {
-    delete semaphore;
-    delete [] semName;
+    delete waiters;
 }
 
 const char *
@@ -41,33 +42,146 @@ Lock::GetName() const
     return name;
 }
 
+/// Waiters do not compete for the lock when it is released: `Release`
+/// hands it over to one of them, and wakes it up as the owner.
 void Lock::Acquire()
 {
     DEBUG('t', "ACQUIRING %s: The owner is %p and the current is %p\n", GetName(), owner, currentThread);
     ASSERT(!IsHeldByCurrentThread());
 
-#ifdef LOCK_INVERSION_PRIORITY_SAFE
-    int priority = currentThread->GetPriority();
-    if (owner != nullptr && owner->GetPriority() < priority)
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (owner == nullptr)
     {
-        DEBUG('b', "The owner %s has lower priority than the current thread %s.\n", owner->GetName(), currentThread->GetName());
-        scheduler->SwitchPriority(owner, priority);
+        Take(currentThread);
+        if (profile != nullptr)
+        {
+            profile->Acquired(false, acquiredAt);
+        }
     }
+    else
+    {
+        unsigned long since = stats->totalTicks;
+        currentThread->waitingOn = this;
+#ifdef LOCK_INVERSION_PRIORITY_SAFE
+        Donate(currentThread->GetPriority());
 #endif
+        waiters->Append(currentThread);
+        currentThread->Sleep();
+        ASSERT(owner == currentThread);
+        if (profile != nullptr)
+        {
+            profile->Acquired(true, since);
+        }
+    }
 
-    semaphore->P();
-    owner = currentThread;
+    interrupt->SetLevel(oldLevel);
 }
 
 void Lock::Release()
 {
     DEBUG('t', "RELEASING %s: The owner is %p and the current is %p\n", GetName(), owner, currentThread);
     ASSERT(IsHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    Lock **held = &currentThread->heldLocks;
+    while (*held != this)
+    {
+        ASSERT(*held != nullptr);
+        held = &(*held)->nextHeld;
+    }
+    *held = nextHeld;
+    nextHeld = nullptr;
+    owner = nullptr;
+    if (profile != nullptr)
+    {
+        profile->Released(acquiredAt);
+    }
+
+    Thread *next = scheduler->PopWaiter(waiters);
+    if (next != nullptr)
+    {
+        Take(next);
 #ifdef LOCK_INVERSION_PRIORITY_SAFE
-    currentThread->ResetPriority();
+        // It now gets the priorities of the waiters left.
+        RestorePriority(next);
 #endif
-    owner = nullptr;
-    semaphore->V();
+        scheduler->ReadyToRun(next);
+    }
+#ifdef LOCK_INVERSION_PRIORITY_SAFE
+    // Give back what the waiters of this lock passed on, but keep what
+    // the waiters of the other locks held did.
+    RestorePriority(currentThread);
+#endif
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void Lock::Take(Thread *thread)
+{
+    owner = thread;
+    acquiredAt = stats->totalTicks;
+    thread->waitingOn = nullptr;
+    nextHeld = thread->heldLocks;
+    thread->heldLocks = this;
+}
+
+int Lock::HighestWaiter() const
+{
+    int highest = -1;
+    if (waiters->IsEmpty())
+    {
+        return highest;
+    }
+    for (Thread *t = waiters->Head(); t != nullptr; t = waiters->Next(t))
+    {
+        if (t->GetPriority() > highest)
+        {
+            highest = t->GetPriority();
+        }
+    }
+    return highest;
+}
+
+/// The chain ends at a thread that is not waiting for a lock, or that
+/// already runs at `priority` or higher.  A chain that goes round in a
+/// circle, which is a deadlock, ends too, once every thread in it is at
+/// `priority`.
+void Lock::Donate(int priority)
+{
+    for (Lock *lock = this; lock != nullptr && lock->owner != nullptr;
+         lock = lock->owner->waitingOn)
+    {
+        Thread *t = lock->owner;
+        if (t->GetPriority() >= priority)
+        {
+            break;
+        }
+        DEBUG('b', "Thread %s gets priority %d through lock %s.\n",
+              t->GetName(), priority, lock->GetName());
+        scheduler->SwitchPriority(t, priority);
+    }
+}
+
+void Lock::RestorePriority(Thread *thread)
+{
+    int priority = thread->GetRealPriority();
+    for (Lock *lock = thread->heldLocks; lock != nullptr;
+         lock = lock->nextHeld)
+    {
+        int waiter = lock->HighestWaiter();
+        if (waiter > priority)
+        {
+            priority = waiter;
+        }
+    }
+    if (priority != thread->GetPriority())
+    {
+        DEBUG('b', "Thread %s goes back to priority %d.\n",
+              thread->GetName(), priority);
+        scheduler->SwitchPriority(thread, priority);
+    }
 }
 
 bool Lock::IsHeldByCurrentThread() const
@@ -32,6 +32,15 @@
 ///
 /// For convenience, nobody but the thread that holds the lock can free it.
 /// There is no operation for reading the state of the lock.
+///
+/// `Release` hands the lock over to the waiter of highest priority.  With
+/// *LOCK_INVERSION_PRIORITY_SAFE*, a thread that waits for a lock passes its
+/// priority on to the owner, to the owner of the lock that one waits for,
+/// and so on down the chain; and a thread runs with the highest of its own
+/// priority and those of the waiters of every lock it holds.
+///
+/// With `-lp`, every lock adds its acquisitions, waits and hold times to
+/// the counters of its name in `lockProfiler`.
 class Lock
 {
 public:
@@ -55,15 +64,37 @@ public:
     /// Useful for checks in `Release` and in condition variables.
     bool IsHeldByCurrentThread() const;
 
+    /// Next lock held by the same thread.
+    Lock *nextHeld;
+
 private:
+    /// Make `thread` the owner.
+    void Take(Thread *thread);
+
+    /// Highest priority among the waiters, -1 if there are none.
+    int HighestWaiter() const;
+
+    /// Raise the owner to `priority`, and the owners down the chain of
+    /// locks they wait for.
+    void Donate(int priority);
+
+    /// Set the priority of `thread` to what its own priority and the locks
+    /// it holds call for.
+    static void RestorePriority(Thread *thread);
+
     /// For debugging.
     const char *name;
-    
+
     Thread *owner;
 
-    Semaphore *semaphore;
-    char *semName;
-    // Add other needed fields here.
+    /// Threads waiting to acquire the lock.
+    ThreadQueue *waiters;
+
+    /// Counters of the lock name, null unless profiling.
+    LockProfile *profile;
+
+    /// Simulated time at which the owner got the lock.
+    unsigned long acquiredAt;
 };
 
 #endif
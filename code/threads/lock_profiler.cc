@@ -0,0 +1,145 @@
+/// Routines to count the contention on locks.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "lock_profiler.hh"
+#include "system.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/// Name given to locks created without one.
+static const char UNNAMED[] = "(unnamed)";
+
+/// Ticks gone by since `since`; none if the tick count was restarted in
+/// between.
+static unsigned long
+Elapsed(unsigned long since)
+{
+    return stats->totalTicks >= since ? stats->totalTicks - since : 0;
+}
+
+void
+LockProfile::Acquired(bool wasContended, unsigned long since)
+{
+    acquisitions++;
+    if (!wasContended)
+    {
+        return;
+    }
+    unsigned long waited = Elapsed(since);
+    contended++;
+    waitTicks += waited;
+    if (waited > maxWait)
+    {
+        maxWait = waited;
+    }
+}
+
+void
+LockProfile::Released(unsigned long since)
+{
+    unsigned long held = Elapsed(since);
+    holdTicks += held;
+    if (held > maxHold)
+    {
+        maxHold = held;
+    }
+}
+
+LockProfiler::LockProfiler()
+{
+    profiles = nullptr;
+    numProfiles = 0;
+}
+
+LockProfiler::~LockProfiler()
+{
+    while (profiles != nullptr)
+    {
+        LockProfile *p = profiles;
+        profiles = p->next;
+        delete [] p->name;
+        delete p;
+    }
+}
+
+/// Locks are created seldom, so a linear search is enough.
+LockProfile *
+LockProfiler::Find(const char *name)
+{
+    if (name == nullptr)
+    {
+        name = UNNAMED;
+    }
+
+    LockProfile **last = &profiles;
+    for (; *last != nullptr; last = &(*last)->next)
+    {
+        if (strcmp((*last)->name, name) == 0)
+        {
+            return *last;
+        }
+    }
+
+    LockProfile *p = new LockProfile;
+    p->name = new char [strlen(name) + 1];
+    strcpy(p->name, name);
+    p->acquisitions = p->contended = 0;
+    p->waitTicks = p->maxWait = 0;
+    p->holdTicks = p->maxHold = 0;
+    p->next = nullptr;
+    *last = p;
+    numProfiles++;
+    return p;
+}
+
+/// Longest total wait first; most acquisitions first among equals.
+int
+LockProfiler::Compare(const void *a, const void *b)
+{
+    const LockProfile *x = *(const LockProfile * const *) a;
+    const LockProfile *y = *(const LockProfile * const *) b;
+    if (x->waitTicks != y->waitTicks)
+    {
+        return x->waitTicks > y->waitTicks ? -1 : 1;
+    }
+    if (x->acquisitions != y->acquisitions)
+    {
+        return x->acquisitions > y->acquisitions ? -1 : 1;
+    }
+    return strcmp(x->name, y->name);
+}
+
+void
+LockProfiler::Print() const
+{
+    LockProfile **sorted = new LockProfile * [numProfiles + 1];
+    unsigned n = 0;
+    for (LockProfile *p = profiles; p != nullptr; p = p->next)
+    {
+        if (p->acquisitions > 0)
+        {
+            sorted[n++] = p;
+        }
+    }
+    if (n > 0)
+    {
+        qsort(sorted, n, sizeof *sorted, Compare);
+
+        printf("Lock contention:\n");
+        printf("    %-24s %9s %9s %10s %8s %10s %8s\n", "lock", "acquired",
+               "contended", "wait", "max", "hold", "max");
+        for (unsigned i = 0; i < n; i++)
+        {
+            const LockProfile *p = sorted[i];
+            printf("    %-24s %9lu %9lu %10lu %8lu %10lu %8lu\n", p->name,
+                   p->acquisitions, p->contended, p->waitTicks, p->maxWait,
+                   p->holdTicks, p->maxHold);
+        }
+    }
+    delete [] sorted;
+}
@@ -0,0 +1,71 @@
+/// Contention counters for the locks of the kernel.
+///
+/// Locks are profiled by name: every lock called the same adds to the same
+/// counters, so that locks created for each object of a kind (one per open
+/// file, say) are reported together.  A lock looks its counters up once,
+/// when it is created, and afterwards only adds to them.
+///
+/// Profiling is off unless Nachos is run with `-lp`; then the counters are
+/// printed when the machine halts, the locks waited for longest first.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_LOCKPROFILER__HH
+#define NACHOS_THREADS_LOCKPROFILER__HH
+
+#include "lib/utility.hh"
+
+/// The counters of every lock with a given name.  Times are in ticks of
+/// simulated time.
+class LockProfile
+{
+public:
+    /// A lock was acquired; if `wasContended`, after blocking since the
+    /// simulated time `since`.
+    void Acquired(bool wasContended, unsigned long since);
+
+    /// A lock held since the simulated time `since` was released.
+    void Released(unsigned long since);
+
+private:
+    friend class LockProfiler;
+
+    /// Copied: locks are often gone by the time the report is printed.
+    char *name;
+
+    unsigned long acquisitions;
+    unsigned long contended;
+    unsigned long waitTicks;
+    unsigned long maxWait;
+    unsigned long holdTicks;
+    unsigned long maxHold;
+
+    /// Next profile, in order of creation.
+    LockProfile *next;
+};
+
+class LockProfiler
+{
+public:
+    LockProfiler();
+
+    ~LockProfiler();
+
+    /// The counters for locks called `name`, created if needed.
+    LockProfile *Find(const char *name);
+
+    /// Print the counters of every lock acquired at least once, by total
+    /// time waited.
+    void Print() const;
+
+private:
+    /// Order of the report, for `qsort`.
+    static int Compare(const void *a, const void *b);
+
+    LockProfile *profiles;
+    unsigned numProfiles;
+};
+
+#endif
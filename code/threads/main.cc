@@ -10,9 +10,10 @@
 /// Usage
 /// =====
 ///
-///     nachos [-d <debugflags>] [-do <debugopts>] [-p]
-///            [-rs <random seed #>] [-z] [-tt]
-///            [-s] [-x <nachos file>] [-tc <consoleIn> <consoleOut>]
+///     nachos [-d <debugflags>] [-do <debugopts>] [-p|-pt [<slice>]]
+///            [-rs <random seed #>] [-sp <policy>] [-sk <stacks>] [-lp] [-z]
+///            [-tt] [-s] [-m <pages>] [-mt <trace file>] [-dp] [-cc <frames>]
+///            [-x <nachos file>] [-tc <consoleIn> <consoleOut>] [-tb]
 ///            [-f] [-cp <unix file> <nachos file>] [-pr <nachos file>]
 ///            [-rm <nachos file>] [-ls] [-D] [-c] [-tf]
 ///            [-n <network reliability>] [-id <machine id>]
@@ -25,8 +26,18 @@
 ///            `utility.hh`).
 /// * `-do` -- enables options that modify the behavior when printing
 ///            debugging messages.
-/// * `-p`  -- enables preemptive multitasking for kernel threads.
+/// * `-p`  -- enables preemptive multitasking for kernel threads, with an
+///            optional time slice in microseconds of host CPU time.
+/// * `-pt` -- like `-p`, but single-steps Nachos from a monitor process
+///            with `ptrace`; the time slice is in host instructions.  Much
+///            slower, but repeatable.
 /// * `-rs` -- causes `Yield` to occur at random (but repeatable) spots.
+/// * `-sp` -- sets the scheduling policy: `priority` (the default),
+///            `mlfq` or `fair`.
+/// * `-sk` -- sets how many stacks of finished threads are kept for new
+///            ones.
+/// * `-lp` -- counts how long threads wait for and hold every lock, and
+///            prints it when the machine halts.
 /// * `-z`  -- prints version and copyright information, and exits.
 ///
 /// *THREADS* options
@@ -39,8 +50,16 @@
 /// ----------------------
 ///
 /// * `-s`  -- causes user programs to be executed in single-step mode.
+/// * `-m`  -- sets the size of the physical memory, in pages.
+/// * `-mt` -- writes a trace of the pages accessed by user programs to a
+///            host file, for `bin/pagesim`.
+/// * `-dp` -- merges identical pages of user programs into copy-on-write
+///            frames.
+/// * `-cc` -- sets how many frames hold compressed evicted pages before
+///            they go to swap (*VMEM* only); 0 disables the cache.
 /// * `-x`  -- runs a user program.
 /// * `-tc` -- tests the console.
+/// * `-tb` -- tests the performance of bitmaps.
 ///
 /// *FILESYS* options
 /// -----------------
@@ -92,6 +111,7 @@ void PerformanceTest(void);
 void StartProcess(const char *file);
 void ConsoleTest(const char *in, const char *out);
 void SynchConsoleTest();
+void BitmapPerformanceTest();
 void MailTest(int networkID);
 
 static inline void
@@ -165,6 +185,11 @@ int main(int argc, char **argv)
                                // will loop forever waiting for console
                                // input.
         }
+        else if (!strcmp(*argv, "-tb"))
+        { // Time bitmap operations.
+            BitmapPerformanceTest();
+            interrupt->Halt();
+        }
         else if (!strcmp(*argv, "-sc"))
         { // Test the Synch console.
             SynchConsoleTest();
@@ -12,8 +12,10 @@
 #include "system.hh"
 
 // UNIX and Linux-specific headers.
+#include <signal.h>
 #include <unistd.h>
 #include <sys/ptrace.h>
+#include <sys/time.h>
 #include <sys/wait.h>
 #include <sys/user.h>
 
@@ -23,16 +25,45 @@
 static void ContextSwitch();
 static void MonitorProcess(int childPid, unsigned long timeSliceLength);
 static void LetMeBeMonitored();
+static void StartTimer(unsigned long timeSliceLength);
+static void TimeSliceExpired(int sig);
 
-static bool inContextSwitch = false;
+/// Set while a forced context switch is being decided on, so that no other
+/// one is forced meanwhile.  It is `volatile` since the signal handler
+/// reads and writes it.
+static volatile sig_atomic_t inContextSwitch = false;
+
+PreemptiveScheduler::PreemptiveScheduler()
+{
+    timerSet = false;
+}
+
+PreemptiveScheduler::~PreemptiveScheduler()
+{
+    if (timerSet) {
+        struct itimerval off = {};
+        setitimer(ITIMER_VIRTUAL, &off, nullptr);
+        signal(SIGVTALRM, SIG_IGN);
+    }
+}
 
 /// Set up the preemptive scheduler.
 ///
-/// * `timeSliceLength` means how many machine instructions will last the
-///   time slice for every kernel thread.
+/// * `timeSliceLength` means how long the time slice for every kernel
+///   thread will last; see the header for the units.
+/// * `backend` tells how to force the context switches.
 void
-PreemptiveScheduler::SetUp(unsigned long timeSliceLength)
+PreemptiveScheduler::SetUp(unsigned long timeSliceLength,
+                           PreemptionBackend backend)
 {
+    ASSERT(timeSliceLength > 0);
+
+    if (backend == PREEMPT_SIGNAL) {
+        StartTimer(timeSliceLength);
+        timerSet = true;
+        return;
+    }
+
     int childPid = fork();
     switch (childPid) {
         case -1:
@@ -53,6 +84,60 @@ PreemptiveScheduler::SetUp(unsigned long timeSliceLength)
     }
 }
 
+/// Have the host deliver `SIGVTALRM` every `timeSliceLength`
+/// microseconds of CPU time used by Nachos.  Time spent blocked on the host,
+/// such as waiting for the console, does not count.
+static void
+StartTimer(unsigned long timeSliceLength)
+{
+    struct sigaction action = {};
+    action.sa_handler = TimeSliceExpired;
+    sigemptyset(&action.sa_mask);
+    // The handler may switch to another thread and not return for a long
+    // while; the signal must not stay blocked meanwhile.  Interrupted host
+    // system calls are restarted.
+    action.sa_flags = SA_NODEFER | SA_RESTART;
+    if (sigaction(SIGVTALRM, &action, nullptr) != 0) {
+        DEBUG('p', "Preemptive scheduler: unable to install handler\n");
+        ASSERT(false);
+    }
+
+    struct itimerval slice;
+    slice.it_interval.tv_sec = timeSliceLength / 1000000;
+    slice.it_interval.tv_usec = timeSliceLength % 1000000;
+    slice.it_value = slice.it_interval;
+    if (setitimer(ITIMER_VIRTUAL, &slice, nullptr) != 0) {
+        DEBUG('p', "Preemptive scheduler: unable to set interval timer\n");
+        ASSERT(false);
+    }
+    DEBUG('p', "Preemptive scheduler: time slice of %lu microseconds\n",
+          timeSliceLength);
+}
+
+/// Handler of `SIGVTALRM`: the time slice of the running thread is over.
+///
+/// It follows the same protocol as `ContextSwitch`, which the monitor
+/// process injects.  The host saves and restores every register around a
+/// signal handler, so there is nothing else to save.  If interrupts are
+/// disabled the switch has to wait until they are enabled again, so it is
+/// just requested.
+static void
+TimeSliceExpired(int sig)
+{
+    if (inContextSwitch || interrupt == nullptr || currentThread == nullptr) {
+        return;
+    }
+
+    inContextSwitch = true;
+    if (interrupt->GetLevel() == INT_ON) {
+        inContextSwitch = false;
+        currentThread->Yield();
+    } else {
+        interrupt->YieldOnReturn();
+        inContextSwitch = false;
+    }
+}
+
 void
 LetMeBeMonitored()
 {
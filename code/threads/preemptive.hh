@@ -1,6 +1,12 @@
 /// Extension to make kernel threads be periodically preempted.
 ///
-/// It only works on Linux x86 environments.
+/// There are two ways of doing it.  By default, an interval timer of the
+/// host raises a signal every time slice of CPU time, and the signal
+/// handler switches to another thread; in between, Nachos runs at native
+/// speed.  The other one forks a monitor process that single-steps Nachos
+/// with `ptrace`, and injects a context switch every so many instructions;
+/// it is much slower, but time slices are exactly repeatable.  It only
+/// works on Linux x86 environments.
 ///
 /// Copyright (c) 2007      Universidad de Las Palmas de Gran Canaria.
 ///               2016-2021 Docentes de la Universidad Nacional de Rosario.
@@ -13,21 +19,29 @@
 #define NACHOS_THREADS_PREEMPTIVE__HH
 
 
+enum PreemptionBackend {
+    PREEMPT_SIGNAL,  ///< Host interval timer and signal.
+    PREEMPT_PTRACE   ///< Monitor process single-stepping Nachos.
+};
+
 class PreemptiveScheduler {
 public:
 
-    PreemptiveScheduler()
-    {}
+    PreemptiveScheduler();
 
-    ~PreemptiveScheduler()
-    {}
+    /// Stop the interval timer, if it was set up.
+    ~PreemptiveScheduler();
 
     /// Set up time slicing between kernel threads.
     ///
-    /// * `timeSliceLength` is the time slice duration, measured in native
-    ///   x86 machine instructions.
-    void SetUp(unsigned long timeSliceLength);
-
+    /// * `timeSliceLength` is the time slice duration, measured in
+    ///   microseconds of host CPU time with `PREEMPT_SIGNAL`, and in native
+    ///   x86 machine instructions with `PREEMPT_PTRACE`.
+    void SetUp(unsigned long timeSliceLength,
+               PreemptionBackend backend = PREEMPT_SIGNAL);
+
+private:
+    bool timerSet;
 };
 
 
@@ -0,0 +1,88 @@
+/// Routines to manage the queue of threads that are ready to run.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "ready_queue.hh"
+
+static_assert(ReadyQueue::NUM_LEVELS <= BITS_IN_WORD,
+              "Every priority level needs a bit in `nonEmpty`.");
+
+ReadyQueue::ReadyQueue()
+{
+    nonEmpty = 0;
+}
+
+void ReadyQueue::Append(Thread *thread, unsigned level)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(level < NUM_LEVELS);
+
+    levels[level].SortedInsert(thread, level);
+    nonEmpty |= 1u << level;
+}
+
+Thread *
+ReadyQueue::Pop()
+{
+    if (nonEmpty == 0)
+    {
+        return nullptr;
+    }
+
+    unsigned level = TopLevel();
+    Thread *thread = levels[level].Pop();
+    if (levels[level].IsEmpty())
+    {
+        nonEmpty &= ~(1u << level);
+    }
+    return thread;
+}
+
+bool ReadyQueue::Remove(Thread *thread)
+{
+    if (!Has(thread))
+    {
+        return false;
+    }
+
+    unsigned level = thread->queueLink.GetKey();
+    levels[level].Remove(thread);
+    if (levels[level].IsEmpty())
+    {
+        nonEmpty &= ~(1u << level);
+    }
+    return true;
+}
+
+bool ReadyQueue::Has(Thread *thread) const
+{
+    ASSERT(thread != nullptr);
+
+    // The thread may be waiting on some other queue, with a stale key.
+    unsigned long level = thread->queueLink.GetKey();
+    return level < NUM_LEVELS && levels[level].Has(thread);
+}
+
+bool ReadyQueue::IsEmpty() const
+{
+    return nonEmpty == 0;
+}
+
+int ReadyQueue::TopLevel() const
+{
+    if (nonEmpty == 0)
+    {
+        return -1;
+    }
+    return BITS_IN_WORD - 1 - __builtin_clz(nonEmpty);
+}
+
+void ReadyQueue::Apply(void (*func)(Thread *)) const
+{
+    for (unsigned i = NUM_LEVELS; i > 0; i--)
+    {
+        levels[i - 1].Apply(func);
+    }
+}
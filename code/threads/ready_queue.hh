@@ -0,0 +1,59 @@
+/// Queue of threads that are ready to run, by priority.
+///
+/// There is a FIFO per priority level, linked through `Thread::queueLink`,
+/// and a bitmap with a bit set for every level that is not empty, so that
+/// taking the next thread, adding one and taking an arbitrary one out are
+/// all constant time, however many threads are ready.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_READYQUEUE__HH
+#define NACHOS_THREADS_READYQUEUE__HH
+
+#include "thread.hh"
+
+class ReadyQueue
+{
+public:
+    /// Number of priority levels; levels go from 0 to `NUM_LEVELS - 1`.
+    static const unsigned NUM_LEVELS = MAX_PRIORITY + 1;
+
+    ReadyQueue();
+
+    /// Put `thread` at the end of the FIFO of `level`.
+    void Append(Thread *thread, unsigned level);
+
+    /// Take the first thread of the highest level that is not empty.
+    ///
+    /// Returns null if there is none.
+    Thread *Pop();
+
+    /// Take `thread` out of the queue.
+    ///
+    /// Returns whether it was on it.
+    bool Remove(Thread *thread);
+
+    /// Is `thread` on the queue?
+    bool Has(Thread *thread) const;
+
+    bool IsEmpty() const;
+
+    /// Highest level with a thread, or -1 if the queue is empty.
+    int TopLevel() const;
+
+    /// Apply `func` to every thread, from the highest level down.
+    void Apply(void (*func)(Thread *)) const;
+
+private:
+    /// Threads of every level.  A thread is inserted with its level as the
+    /// key, so that its link tells where it is.  All keys in a FIFO are
+    /// equal, so a sorted insertion just appends.
+    ThreadQueue levels[NUM_LEVELS];
+
+    /// Bit `i` is set if `levels[i]` is not empty.
+    unsigned nonEmpty;
+};
+
+#endif
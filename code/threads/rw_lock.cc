@@ -0,0 +1,182 @@
+/// Routines for reader-writer locks.
+///
+/// Interrupts are disabled while the state of the lock is looked at or
+/// changed, as in `Semaphore` and `Lock`.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "rw_lock.hh"
+
+RWLock::RWLock(const char *debugName)
+{
+    name = debugName;
+    readers = 0;
+    writer = nullptr;
+    waitingReaders = new ThreadQueue;
+    waitingWriters = new ThreadQueue;
+    profile = lockProfiler != nullptr ? lockProfiler->Find(debugName)
+                                      : nullptr;
+    acquiredAt = 0;
+}
+
+RWLock::~RWLock()
+{
+    delete waitingWriters;
+    delete waitingReaders;
+}
+
+const char *
+RWLock::GetName() const
+{
+    return name;
+}
+
+/// Once woken up, the reader already holds the lock: the thread that let
+/// it in counted it.
+void
+RWLock::AcquireRead()
+{
+    ASSERT(!IsWriteHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (writer == nullptr && waitingWriters->IsEmpty())
+    {
+        if (readers++ == 0)
+        {
+            acquiredAt = stats->totalTicks;
+        }
+        if (profile != nullptr)
+        {
+            profile->Acquired(false, acquiredAt);
+        }
+    }
+    else
+    {
+        unsigned long since = stats->totalTicks;
+        DEBUG('t', "Thread %s waits to read %s\n",
+              currentThread->GetName(), name);
+        waitingReaders->Append(currentThread);
+        currentThread->Sleep();
+        if (profile != nullptr)
+        {
+            profile->Acquired(true, since);
+        }
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+RWLock::ReleaseRead()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    ASSERT(readers > 0);
+    if (--readers == 0)
+    {
+        if (profile != nullptr)
+        {
+            profile->Released(acquiredAt);
+        }
+        AdmitWriter();
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+RWLock::AcquireWrite()
+{
+    ASSERT(!IsWriteHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (writer == nullptr && readers == 0)
+    {
+        writer = currentThread;
+        acquiredAt = stats->totalTicks;
+        if (profile != nullptr)
+        {
+            profile->Acquired(false, acquiredAt);
+        }
+    }
+    else
+    {
+        unsigned long since = stats->totalTicks;
+        DEBUG('t', "Thread %s waits to write %s\n",
+              currentThread->GetName(), name);
+        waitingWriters->Append(currentThread);
+        currentThread->Sleep();
+        ASSERT(writer == currentThread);
+        if (profile != nullptr)
+        {
+            profile->Acquired(true, since);
+        }
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+RWLock::ReleaseWrite()
+{
+    ASSERT(IsWriteHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    writer = nullptr;
+    if (profile != nullptr)
+    {
+        profile->Released(acquiredAt);
+    }
+    if (!waitingReaders->IsEmpty())
+    {
+        AdmitReaders();
+    }
+    else
+    {
+        AdmitWriter();
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+bool
+RWLock::IsWriteHeldByCurrentThread() const
+{
+    return writer == currentThread;
+}
+
+/// The readers of highest priority are made ready first.
+void
+RWLock::AdmitReaders()
+{
+    ASSERT(writer == nullptr);
+
+    if (readers == 0 && !waitingReaders->IsEmpty())
+    {
+        acquiredAt = stats->totalTicks;
+    }
+    Thread *t;
+    while ((t = scheduler->PopWaiter(waitingReaders)) != nullptr)
+    {
+        readers++;
+        scheduler->ReadyToRun(t);
+    }
+}
+
+void
+RWLock::AdmitWriter()
+{
+    ASSERT(writer == nullptr && readers == 0);
+
+    writer = scheduler->PopWaiter(waitingWriters);
+    if (writer != nullptr)
+    {
+        acquiredAt = stats->totalTicks;
+        scheduler->ReadyToRun(writer);
+    }
+}
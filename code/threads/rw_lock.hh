@@ -0,0 +1,79 @@
+/// Reader-writer lock, a synchronization primitive
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_RWLOCK__HH
+#define NACHOS_THREADS_RWLOCK__HH
+
+#include "thread.hh"
+#include "system.hh"
+
+/// This class defines a “reader-writer lock”.
+///
+/// Any number of threads can hold the lock for reading at a time, or a
+/// single one for writing:
+///
+/// * `AcquireRead` -- wait until no thread holds the lock for writing, nor
+///   waits to.
+/// * `AcquireWrite` -- wait until no thread holds the lock at all.
+/// * `ReleaseRead`, `ReleaseWrite` -- give up what was acquired.
+///
+/// Like `Lock`, releasing hands the lock over to the waiters instead of
+/// letting them compete for it.  Turns alternate so that neither side
+/// starves: readers that come while a writer waits go after it, and a
+/// writer that releases the lock lets in every reader waiting before the
+/// next writer.  Writers take their turn by priority.
+///
+/// Readers are not tracked one by one, so waiters do not pass their
+/// priority on to the holders.
+class RWLock
+{
+public:
+    /// Constructor: set up the lock as free.
+    RWLock(const char *debugName);
+
+    ~RWLock();
+
+    /// For debugging.
+    const char *GetName() const;
+
+    /// Operations on the lock.
+    ///
+    /// All of them must be *atomic*.
+    void AcquireRead();
+    void ReleaseRead();
+    void AcquireWrite();
+    void ReleaseWrite();
+
+    /// Returns `true` if the current thread holds the lock for writing.
+    bool IsWriteHeldByCurrentThread() const;
+
+private:
+    /// Let in every reader waiting.
+    void AdmitReaders();
+
+    /// Let in the writer of highest priority, if any is waiting.
+    void AdmitWriter();
+
+    /// For debugging.
+    const char *name;
+
+    /// Threads holding the lock for reading.
+    unsigned readers;
+
+    /// Thread holding the lock for writing, if any.
+    Thread *writer;
+
+    ThreadQueue *waitingReaders;
+    ThreadQueue *waitingWriters;
+
+    /// Counters of the lock name, null unless profiling.  The hold time
+    /// counted is the time the lock is held at all, by a writer or by one
+    /// reader or more.
+    LockProfile *profile;
+    unsigned long acquiredAt;
+};
+
+#endif
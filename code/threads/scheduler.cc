@@ -9,8 +9,13 @@
 /// needed to wait for a lock, and the lock was busy, we would end up calling
 /// `FindNextToRun`, and that would put us in an infinite loop.
 ///
-/// Very simple implementation -- no priorities, straight FIFO.  Might need
-/// to be improved in later assignments.
+/// Ready threads are kept in a `ReadyQueue`, FIFO within each priority
+/// level; the highest level with a ready thread runs first.  The level is
+/// either the static priority of the thread, or its multilevel feedback
+/// queue level, depending on the policy chosen at boot.  Under the fair
+/// policy, they are kept in a `ThreadHeap` by virtual runtime instead.
+/// Real-time threads are kept apart, in a `ThreadHeap` by deadline, and
+/// go first.
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2021 Docentes de la Universidad Nacional de Rosario.
@@ -26,22 +31,48 @@
 
 #include <stdio.h>
 
+/// Millionths of the CPU, for real-time reservations.
+static const unsigned long UTILIZATION_SCALE = 1000000;
+
+static inline bool
+IsRealTime(const Thread *thread)
+{
+    return thread->sched.budget > 0;
+}
+
 /// Initialize the list of ready but not running threads to empty.
-Scheduler::Scheduler()
+///
+/// * `policy_` tells how to choose the next thread to run.
+Scheduler::Scheduler(SchedulingPolicy policy_)
 {
-    for (unsigned i = 0; i <= MAX_PRIORITY; i++)
-    {
-        readyList[i] = new List<Thread *>;
-    }
+    ASSERT(policy_ < NUM_SCHEDULING_POLICIES);
+
+    readyList = new ReadyQueue;
+    fairList = new ThreadHeap(&SchedulingState::vruntime);
+    realTimeList = new ThreadHeap(&SchedulingState::deadline);
+    throttledList = new ThreadQueue;
+    releaseAlarm = 0;
+    policy = policy_;
+    minVruntime = 0;
+    reserved = 0;
+    lastCharge = lastReset = 0;
+    idling = false;
+    epoch = 0;
+#ifdef VMEM
+    suspendedList = new SuspendedQueue;
+#endif
 }
 
 /// De-allocate the list of ready threads.
 Scheduler::~Scheduler()
 {
-    for (unsigned i = 0; i <= MAX_PRIORITY; i++)
-    {
-        delete readyList[i];
-    }
+    delete readyList;
+    delete fairList;
+    delete realTimeList;
+    delete throttledList;
+#ifdef VMEM
+    delete suspendedList;
+#endif
 }
 
 /// Mark a thread as ready, but not running.
@@ -56,12 +87,78 @@ void Scheduler::ReadyToRun(Thread *thread)
 
     thread->SetStatus(READY);
 
-    int priority = MAX_PRIORITY;
+#ifdef VMEM
+    if (thread->IsSuspended())
+    {
+        DEBUG('t', "Thread %s is suspended, not scheduling it\n",
+              thread->GetName());
+        return;
+    }
+#endif
+
+    if (IsRealTime(thread))
+    {
+        SchedulingState *s = &thread->sched;
+        if (s->remaining == 0)
+        {
+            // It used up its budget without getting its job done: the
+            // rest has to wait for the next period.
+            DEBUG('t', "Thread %s ran out of budget\n", thread->GetName());
+            s->overruns++;
+            stats->numBudgetOverruns++;
+            s->release = s->deadline;
+            s->deadline += s->period;
+            s->remaining = s->budget;
+        }
+        if (s->release > stats->totalTicks)
+        {
+            Throttle(thread);
+        }
+        else
+        {
+            DEBUG('b', "With deadline %llu.\n", s->deadline);
+            realTimeList->Insert(thread);
+        }
+        return;
+    }
+
+    if (policy == POLICY_FAIR)
+    {
+        SchedulingState *s = &thread->sched;
+        if (s->vruntime < minVruntime)
+        {
+            s->vruntime = minVruntime;
+        }
+        DEBUG('b', "With virtual runtime %llu.\n", s->vruntime);
+        fairList->Insert(thread);
+        return;
+    }
+
+    unsigned level = QueueLevel(thread);
+    DEBUG('b', "With priority %u.\n", level);
+    readyList->Append(thread, level);
+}
+
+unsigned
+Scheduler::QueueLevel(Thread *thread)
+{
+    if (policy == POLICY_MLFQ)
+    {
+        SchedulingState *s = &thread->sched;
+        if (s->epoch != epoch)
+        {
+            s->level = 0;
+            s->used = 0;
+            s->epoch = epoch;
+        }
+        return MAX_PRIORITY - s->level;
+    }
+
 #ifdef SCHEDULER_PRIORITY
-    priority = thread->GetPriority();
+    return thread->GetPriority();
+#else
+    return MAX_PRIORITY;
 #endif
-    DEBUG('b', "With priority %d.\n", priority);
-    readyList[priority]->Append(thread);
 }
 
 /// Return the next thread to be scheduled onto the CPU.
@@ -73,10 +170,21 @@ Thread *
 Scheduler::FindNextToRun()
 {
     DEBUG('b', "Finding next thread to run.\n");
-    unsigned i;
-    for (i = MAX_PRIORITY; i > 0 && readyList[i]->IsEmpty(); i--)
-        ;
-    return readyList[i]->Pop();
+    ReleaseThrottled();
+    if (!realTimeList->IsEmpty())
+    {
+        return realTimeList->Pop();
+    }
+    if (policy == POLICY_FAIR)
+    {
+        Thread *thread = fairList->Pop();
+        if (thread != nullptr && thread->sched.vruntime > minVruntime)
+        {
+            minVruntime = thread->sched.vruntime;
+        }
+        return thread;
+    }
+    return readyList->Pop();
 }
 
 /// Dispatch the CPU to `nextThread`.
@@ -96,18 +204,21 @@ void Scheduler::Run(Thread *nextThread)
 
     Thread *oldThread = currentThread;
 
-#ifdef USER_PROGRAM // Ignore until running user programs.
-    if (currentThread->space != nullptr)
-    {
-        // If this thread is a user program, save the user's CPU registers.
-        currentThread->SaveUserState();
-        currentThread->space->SaveState();
-    }
-#endif
-
     oldThread->CheckOverflow(); // Check if the old thread had an undetected
                                 // stack overflow.
 
+    Charge(oldThread);
+    if (policy == POLICY_MLFQ && oldThread->GetStatus() == BLOCKED)
+    {
+        // It gave up the CPU to wait, so it is not CPU bound.
+        SchedulingState *s = &oldThread->sched;
+        if (s->level > 0)
+        {
+            s->level--;
+        }
+        s->used = 0;
+    }
+
     currentThread = nextThread;        // Switch to the next thread.
     currentThread->SetStatus(RUNNING); // `nextThread` is now running.
 
@@ -129,16 +240,22 @@ void Scheduler::Run(Thread *nextThread)
     // were still running on the old thread's stack!
     if (threadToBeDestroyed != nullptr)
     {
+        if (IsRealTime(threadToBeDestroyed))
+        {
+            SetRealTime(threadToBeDestroyed, 0, 0);
+        }
         delete threadToBeDestroyed;
         threadToBeDestroyed = nullptr;
     }
 
 #ifdef USER_PROGRAM
+    // The user registers of every thread stay in the thread, and the
+    // address space stays in the MMU until another one takes its place, so
+    // there is nothing to save for the old thread.  Switches between
+    // threads that only run in the kernel leave the machine alone.
     if (currentThread->space != nullptr)
     {
-        // If there is an address space to restore, do it.
         currentThread->RestoreUserState();
-        currentThread->space->RestoreState();
     }
 #endif
 }
@@ -158,18 +275,361 @@ void Scheduler::Print()
 {
     printf("Ready list contents:\n");
 
-    for (unsigned i = 0; i <= MAX_PRIORITY; i++)
+    readyList->Apply(ThreadPrint);
+    fairList->Apply(ThreadPrint);
+    realTimeList->Apply(ThreadPrint);
+    if (!throttledList->IsEmpty())
     {
-        readyList[i]->Apply(ThreadPrint);
+        printf("\nWaiting for their period: ");
+        throttledList->Apply(ThreadPrint);
     }
+#ifdef VMEM
+    if (!suspendedList->IsEmpty())
+    {
+        printf("\nSuspended: ");
+        suspendedList->Apply(ThreadPrint);
+    }
+#endif
 }
 
+/// Only a ready thread has to move to another queue; a blocked one is put
+/// on the right one when it wakes up.
 void Scheduler::SwitchPriority(Thread *thread, int priority)
 {
+    bool ready = RemoveReady(thread);
     thread->SetPriority(priority);
-    if (readyList[thread->GetRealPriority()]->Has(thread))
+    if (ready)
     {
-        readyList[thread->GetRealPriority()]->Remove(thread);
+        ReadyToRun(thread);
     }
-    ReadyToRun(thread);
-}
\ No newline at end of file
+}
+
+/// Waiters are few, so the queue is kept in order of arrival and looked
+/// through; a priority may change while its thread waits, when it gets one
+/// passed on by a lock.
+Thread *Scheduler::PopWaiter(ThreadQueue *queue)
+{
+    ASSERT(queue != nullptr);
+
+#ifdef SCHEDULER_PRIORITY
+    if (queue->IsEmpty())
+    {
+        return nullptr;
+    }
+    Thread *best = queue->Head();
+    for (Thread *t = queue->Next(best); t != nullptr; t = queue->Next(t))
+    {
+        if (t->GetPriority() > best->GetPriority())
+        {
+            best = t;
+        }
+    }
+    queue->Remove(best);
+    return best;
+#else
+    return queue->Pop();
+#endif
+}
+
+/// Real-time threads waiting for their period are left where they are.
+bool Scheduler::RemoveReady(Thread *thread)
+{
+    if (IsRealTime(thread))
+    {
+        return realTimeList->Remove(thread);
+    }
+    return policy == POLICY_FAIR ? fairList->Remove(thread)
+                                 : readyList->Remove(thread);
+}
+
+void Scheduler::ReleaseThrottled()
+{
+    unsigned long now = stats->totalTicks;
+    while (!throttledList->IsEmpty()
+           && throttledList->Head()->queueLink.GetKey() <= now)
+    {
+        Thread *thread = throttledList->Pop();
+        DEBUG('t', "Period of thread %s begins\n", thread->GetName());
+        ReadyToRun(thread);
+    }
+}
+
+/// The thread that blocked is charged up to now, and the interrupt
+/// handlers that run meanwhile charge nobody: otherwise the idle ticks would
+/// be counted as used by the thread, which holds no CPU.
+void Scheduler::Idle()
+{
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+
+    Charge(currentThread);
+    idling = true;
+    interrupt->Idle();
+    idling = false;
+    lastCharge = stats->totalTicks;
+}
+
+void Scheduler::Throttle(Thread *thread)
+{
+    throttledList->SortedInsert(thread, thread->sched.release);
+    ArmRelease();
+}
+
+/// Dummy function because C++ does not allow pointers to member functions.
+static void
+ReleaseAlarmHandler(void *arg)
+{
+    ASSERT(arg != nullptr);
+    ((Scheduler *) arg)->ReleaseAlarm();
+}
+
+/// An interrupt already pending for an earlier time will do; when it
+/// comes, the next one is scheduled.  Interrupts cannot be cancelled, so a
+/// later one may be left pending too, and find nothing to release.
+void Scheduler::ArmRelease()
+{
+    if (throttledList->IsEmpty())
+    {
+        return;
+    }
+    unsigned long release = throttledList->Head()->queueLink.GetKey();
+    if (releaseAlarm != 0 && releaseAlarm <= release)
+    {
+        return;
+    }
+    unsigned long now = stats->totalTicks;
+    releaseAlarm = release > now ? release : now + 1;
+    interrupt->Schedule(ReleaseAlarmHandler, this, releaseAlarm - now,
+                        ALARM_INT);
+}
+
+/// A real-time thread released while another one runs preempts it at the
+/// next timer interrupt, as when it is released then.
+void Scheduler::ReleaseAlarm()
+{
+    if (releaseAlarm <= stats->totalTicks)
+    {
+        releaseAlarm = 0;
+    }
+    ReleaseThrottled();
+    ArmRelease();
+}
+
+/// Under the multilevel feedback queue, the running thread moves down a
+/// level once it has used up the quantum of its own, and gives up the CPU
+/// early if a thread of a higher level is ready.  Under the fair policy, it
+/// gives up the CPU once some ready thread is behind it in virtual runtime.
+/// Under static priorities, every timer interrupt is a time slice.
+///
+/// Real-time threads preempt the others as soon as they are ready, and
+/// each other by deadline; a real-time thread also gives up the CPU when
+/// its budget runs out.
+bool Scheduler::TimerExpired()
+{
+    ReleaseThrottled();
+    if (IsRealTime(currentThread))
+    {
+        Charge(currentThread);
+        Thread *next = realTimeList->Top();
+        return currentThread->sched.remaining == 0
+               || (next != nullptr
+                   && next->sched.deadline < currentThread->sched.deadline);
+    }
+    if (!realTimeList->IsEmpty())
+    {
+        return true;
+    }
+
+    if (policy == POLICY_FAIR)
+    {
+        Charge(currentThread);
+        Thread *next = fairList->Top();
+        return next != nullptr
+               && next->sched.vruntime < currentThread->sched.vruntime;
+    }
+    if (policy != POLICY_MLFQ)
+    {
+        return true;
+    }
+
+    unsigned long now = stats->totalTicks;
+    if (now < lastReset || now - lastReset >= MLFQ_RESET_PERIOD)
+    {
+        ResetLevels();
+    }
+
+    Charge(currentThread);
+    SchedulingState *s = &currentThread->sched;
+    if (s->used >= MLFQ_QUANTUM << s->level)
+    {
+        if (s->level < MLFQ_LEVELS - 1)
+        {
+            s->level++;
+            DEBUG('t', "Thread \"%s\" moves down to level %u\n",
+                  currentThread->GetName(), s->level);
+        }
+        s->used = 0;
+        return true;
+    }
+    return readyList->TopLevel() > (int) (MAX_PRIORITY - s->level);
+}
+
+SchedulingPolicy
+Scheduler::GetPolicy() const
+{
+    return policy;
+}
+
+/// The weight only changes how fast the thread is charged from now on, so
+/// it does not have to move in the ready queue.
+void Scheduler::SetWeight(Thread *thread, unsigned weight)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(weight > 0);
+
+    thread->sched.weight = weight;
+}
+
+/// The thread is taken off the queue it waits on, if it is ready, and put
+/// on the one of its new class.
+bool Scheduler::SetRealTime(Thread *thread, unsigned long period,
+                            unsigned long budget)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(budget <= period);
+
+    SchedulingState *s = &thread->sched;
+    unsigned long old = IsRealTime(thread)
+                        ? s->budget * UTILIZATION_SCALE / s->period : 0;
+    unsigned long share = budget > 0 ? budget * UTILIZATION_SCALE / period
+                                     : 0;
+    if (reserved - old + share
+          > EDF_MAX_UTILIZATION * UTILIZATION_SCALE / 100)
+    {
+        DEBUG('t', "Reservation of thread %s rejected\n", thread->GetName());
+        return false;
+    }
+
+    bool ready = RemoveReady(thread);
+    if (throttledList->Has(thread))
+    {
+        throttledList->Remove(thread);
+        ready = true;
+    }
+
+    reserved = reserved - old + share;
+    s->period = period;
+    s->budget = s->remaining = budget;
+    s->release = stats->totalTicks;
+    s->deadline = s->release + period;
+    if (ready)
+    {
+        ReadyToRun(thread);
+    }
+    return true;
+}
+
+/// The next period begins when the current one ends; if the job was late,
+/// it begins right away.
+void Scheduler::WaitForNextPeriod()
+{
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+    ASSERT(IsRealTime(currentThread));
+
+    unsigned long now = stats->totalTicks;
+    SchedulingState *s = &currentThread->sched;
+    Charge(currentThread);
+    s->jobs++;
+    stats->numRealTimeJobs++;
+    if (now > s->deadline)
+    {
+        DEBUG('t', "Thread %s missed its deadline by %llu ticks\n",
+              currentThread->GetName(), now - s->deadline);
+        s->missed++;
+        stats->numDeadlinesMissed++;
+    }
+
+    s->release = s->deadline > now ? s->deadline : now;
+    s->deadline = s->release + s->period;
+    s->remaining = s->budget;
+    if (s->release > now)
+    {
+        Throttle(currentThread);
+        currentThread->Sleep();
+    }
+    else
+    {
+        currentThread->Yield();
+    }
+}
+
+void Scheduler::Charge(Thread *thread)
+{
+    unsigned long now = stats->totalTicks;
+    if (!idling && now >= lastCharge)
+    {
+        // The tick counter may have been restarted meanwhile.
+        unsigned long ticks = now - lastCharge;
+        SchedulingState *s = &thread->sched;
+        s->used += ticks;
+        s->runTime += ticks;
+        s->vruntime += ((unsigned long long) ticks << VRUNTIME_SHIFT)
+                       * DEFAULT_WEIGHT / s->weight;
+        s->remaining -= ticks < s->remaining ? ticks : s->remaining;
+    }
+    lastCharge = now;
+}
+
+/// Threads that are not ready get their level reset the next time they
+/// are, since their epoch is behind.
+void Scheduler::ResetLevels()
+{
+    DEBUG('t', "Moving every thread to the top level\n");
+
+    lastReset = stats->totalTicks;
+    epoch++;
+
+    ThreadQueue ready;
+    Thread *thread;
+    while ((thread = readyList->Pop()) != nullptr)
+    {
+        ready.Append(thread);
+    }
+    while ((thread = ready.Pop()) != nullptr)
+    {
+        readyList->Append(thread, QueueLevel(thread));
+    }
+    QueueLevel(currentThread);
+}
+
+#ifdef VMEM
+void Scheduler::Suspend(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(!thread->IsSuspended());
+
+    thread->SetSuspended(true);
+    suspendedList->Append(thread);
+    RemoveReady(thread);
+}
+
+void Scheduler::Resume(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(thread->IsSuspended());
+
+    thread->SetSuspended(false);
+    suspendedList->Remove(thread);
+    // Only ready threads are kept apart; running and blocked ones are left
+    // as they are.
+    if (thread->GetStatus() == READY)
+    {
+        ReadyToRun(thread);
+    }
+}
+
+Thread *
+Scheduler::FirstSuspended()
+{
+    return suspendedList->IsEmpty() ? nullptr : suspendedList->Head();
+}
+#endif
@@ -11,16 +11,60 @@
 #define NACHOS_THREADS_SCHEDULER__HH
 
 #include "thread.hh"
-#include "lib/list.hh"
+#include "ready_queue.hh"
+#include "thread_heap.hh"
+
+/// How the scheduler chooses the next thread to run.
+enum SchedulingPolicy
+{
+    /// Static priorities, round robin among threads of the same one.
+    POLICY_PRIORITY,
+
+    /// Multilevel feedback queue: threads that use up their quantum move
+    /// down a level, threads that block move up one, and every
+    /// `MLFQ_RESET_PERIOD` ticks all of them go back to the top.
+    POLICY_MLFQ,
+
+    /// Proportional share: every thread gets CPU time in proportion to its
+    /// weight.  The ready thread with the lowest virtual runtime -- ticks
+    /// run divided by weight -- runs next.
+    POLICY_FAIR,
+
+    NUM_SCHEDULING_POLICIES
+};
+
+/// Number of multilevel feedback queue levels.
+const unsigned MLFQ_LEVELS = 4;
+
+/// Ticks a thread may run at the top level before it is moved down; the
+/// quantum doubles at every level below.
+const unsigned long MLFQ_QUANTUM = 200;
+
+/// Ticks between resets of every thread to the top level, so that threads
+/// at the bottom do not starve.
+const unsigned long MLFQ_RESET_PERIOD = 5000;
+
+/// Largest share of the CPU, in percent, that real-time threads may
+/// reserve altogether; the rest is left for the other threads.
+const unsigned EDF_MAX_UTILIZATION = 90;
+
+/// Bits of fraction of virtual runtimes, so that threads of large weights
+/// are not charged less than their due by rounding.
+const unsigned VRUNTIME_SHIFT = 10;
 
 /// The following class defines the scheduler/dispatcher abstraction --
 /// the data structures and operations needed to keep track of which
 /// thread is running, and which threads are ready but not running.
+///
+/// Whatever the policy, real-time threads run ahead of the others, by
+/// earliest deadline first.  A real-time thread reserves a budget of CPU
+/// time every period; once the budget of a period runs out, the thread
+/// waits for the next period, so that it cannot starve the rest.
 class Scheduler
 {
 public:
     /// Initialize list of ready threads.
-    Scheduler();
+    Scheduler(SchedulingPolicy policy = POLICY_PRIORITY);
 
     /// De-allocate ready list.
     ~Scheduler();
@@ -34,15 +78,128 @@ public:
     /// Cause `nextThread` to start running.
     void Run(Thread *nextThread);
 
+    /// Wait for an interrupt, when there is no thread to run.  Nobody is
+    /// charged for the ticks the CPU idles.
+    void Idle();
+
     // Print contents of ready list.
     void Print();
 
     // Moves the thread to a different queue.
     void SwitchPriority(Thread *thread, int priority);
 
+    /// Take the thread to wake up from the waiters in `queue`: the one of
+    /// highest priority, and the first to come among those.
+    ///
+    /// Returns null if the queue is empty.
+    Thread *PopWaiter(ThreadQueue *queue);
+
+    /// Account for a timer interrupt.
+    ///
+    /// Returns whether the running thread should give up the CPU.
+    bool TimerExpired();
+
+    SchedulingPolicy GetPolicy() const;
+
+    /// Set the share of the CPU of `thread` under the fair policy.
+    void SetWeight(Thread *thread, unsigned weight);
+
+    /// Make `thread` real time, with `budget` ticks of CPU every `period`
+    /// ticks starting now, or a normal thread again if `budget` is 0.
+    ///
+    /// Returns false, and leaves the thread as it was, if the reservation
+    /// does not fit with the ones of the other real-time threads.
+    bool SetRealTime(Thread *thread, unsigned long period,
+                     unsigned long budget);
+
+    /// The job of the current period of the running thread, which must be
+    /// real time, is done: wait for the next period.
+    void WaitForNextPeriod();
+
+    /// Internal routine -- called from the interrupt that marks the start
+    /// of the next period of a throttled thread.
+    void ReleaseAlarm();
+
+#ifdef VMEM
+    /// Keep `thread` from running until it is resumed.
+    ///
+    /// A suspended thread that becomes ready waits apart from the ready
+    /// list.
+    void Suspend(Thread *thread);
+
+    /// Let a suspended thread run again.
+    void Resume(Thread *thread);
+
+    /// The thread that has been suspended for the longest time, if any.
+    Thread *FirstSuspended();
+#endif
+
 private:
+    /// Level of the ready queue `thread` goes to.
+    unsigned QueueLevel(Thread *thread);
+
+    /// Charge the running thread for the ticks since it was last charged.
+    void Charge(Thread *thread);
+
+    /// Move every thread to the top level of the multilevel feedback
+    /// queue.
+    void ResetLevels();
+
+    /// Make real-time threads whose period has begun ready to run.
+    void ReleaseThrottled();
+
+    /// Make `thread` wait for the start of its next period.
+    void Throttle(Thread *thread);
+
+    /// Have an interrupt pending for the earliest start of a period, so
+    /// that an idle machine neither halts nor misses it.
+    void ArmRelease();
+
+    /// Take `thread` off the ready queue of the policy.
+    ///
+    /// Returns whether it was on it.
+    bool RemoveReady(Thread *thread);
+
     // Queue of threads that are ready to run, but not running.
-    List<Thread *> *readyList[MAX_PRIORITY + 1];
+    ReadyQueue *readyList;
+
+    /// Ready threads under the fair policy.
+    ThreadHeap *fairList;
+
+    /// Ready real-time threads, by deadline.
+    ThreadHeap *realTimeList;
+
+    /// Real-time threads waiting for their next period, by its start.
+    ThreadQueue *throttledList;
+
+    /// Time of the earliest interrupt pending for `ReleaseAlarm`, 0 if
+    /// none.
+    unsigned long releaseAlarm;
+
+    /// Share of the CPU reserved by real-time threads, in millionths.
+    unsigned long reserved;
+
+    /// Virtual runtime of the last thread dispatched under the fair policy.
+    /// It never goes back; threads that were blocked start from it, so
+    /// that they cannot take the CPU for the time they did not use.
+    unsigned long long minVruntime;
+
+    SchedulingPolicy policy;
+
+    /// When the running thread was last charged.
+    unsigned long lastCharge;
+
+    /// Whether the CPU idles, so that no thread is charged.
+    bool idling;
+
+    /// When the levels were last reset, and how many times.
+    unsigned long lastReset;
+    unsigned epoch;
+
+#ifdef VMEM
+    // Suspended threads, in the order they were suspended.
+    SuspendedQueue *suspendedList;
+#endif
 };
 
 #endif
@@ -33,7 +33,7 @@ Semaphore::Semaphore(const char *debugName, int initialValue)
 {
     name  = debugName;
     value = initialValue;
-    queue = new List<Thread *>;
+    queue = new ThreadQueue;
 }
 
 /// De-allocate semaphore, when no longer needed.
@@ -72,7 +72,56 @@ Semaphore::P()
     interrupt->SetLevel(oldLevel);  // Re-enable interrupts.
 }
 
-/// Increment semaphore value, waking up a waiter if necessary.
+/// What the timer of a timed `P` needs to take its thread off the queue.
+struct TimedWait {
+    Thread *thread;
+    ThreadQueue *queue;
+};
+
+/// Timer handler for a timed `P`: wake the thread up if it is still
+/// waiting.  If a `V` got to it first, it is already on its way.
+static void
+TimedOut(void *arg)
+{
+    TimedWait *wait = (TimedWait *) arg;
+    if (wait->queue->Has(wait->thread)) {
+        wait->queue->Remove(wait->thread);
+        scheduler->ReadyToRun(wait->thread);
+    }
+}
+
+/// The timer and the record of the wait live on the stack of the waiting
+/// thread, which stays put until it returns.
+bool
+Semaphore::P(unsigned long timeout)
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (value == 0 && timeout > 0) {
+        TimedWait wait = { currentThread, queue };
+        TimerEntry alarm;
+        timerWheel->Start(&alarm, timeout, TimedOut, &wait);
+        while (value == 0 && alarm.IsPending()) {
+            queue->Append(currentThread);
+            currentThread->Sleep();
+        }
+        timerWheel->Cancel(&alarm);
+    }
+
+    bool acquired = value > 0;
+    if (acquired) {
+        value--;
+    } else {
+        DEBUG('s', "Semaphore %s: P timed out after %lu ticks\n",
+              name, timeout);
+    }
+
+    interrupt->SetLevel(oldLevel);
+    return acquired;
+}
+
+/// Increment semaphore value, waking up a waiter if necessary.  The one of
+/// highest priority goes first.
 ///
 /// As with `P`, this operation must be atomic, so we need to disable
 /// interrupts.  `Scheduler::ReadyToRun` assumes that threads are disabled
@@ -82,7 +131,7 @@ Semaphore::V()
 {
     IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
 
-    Thread *thread = queue->Pop();
+    Thread *thread = scheduler->PopWaiter(queue);
     if (thread != nullptr) {
         // Make thread ready, consuming the `V` immediately.
         scheduler->ReadyToRun(thread);
@@ -21,7 +21,6 @@
 
 
 #include "thread.hh"
-#include "lib/list.hh"
 
 
 /// This class defines a “semaphore”, which has a positive integer as its
@@ -55,6 +54,11 @@ public:
     void P();
     void V();
 
+    /// Like `P`, but give up once `timeout` ticks have gone by.
+    ///
+    /// Returns whether the value was decremented.
+    bool P(unsigned long timeout);
+
 private:
 
     /// For debugging.
@@ -64,7 +68,7 @@ private:
     int value;
 
     /// Queue of threads waiting on `P` because the value is zero.
-    List<Thread *> *queue;
+    ThreadQueue *queue;
 
 };
 
@@ -0,0 +1,194 @@
+/// Routines to manage the pool of thread stacks.
+///
+/// Threads can be preempted anywhere under `-pt`, so interrupts are
+/// disabled while the pool is handed a stack or gives one out.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "stack_pool.hh"
+#include "system.hh"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/// Every word of a stack not used yet holds this.
+static const uintptr_t STACK_PAINT = 0x5A5A5A5A;
+
+/// Bytes of a stack, and of its mapping, guard page included.
+static inline size_t
+StackBytes()
+{
+    return STACK_SIZE * sizeof (uintptr_t);
+}
+
+static inline size_t
+GuardBytes()
+{
+    return getpagesize();
+}
+
+StackPool::StackPool(unsigned maxFree_)
+{
+    freeList = nullptr;
+    numFree = 0;
+    maxFree = maxFree_;
+    numMapped = numReused = 0;
+    numInUse = peakInUse = 0;
+    deepest = 0;
+    deepestOwner[0] = '\0';
+}
+
+StackPool::~StackPool()
+{
+    SetMaxFree(0);
+}
+
+uintptr_t *
+StackPool::Map()
+{
+    void *p = mmap(nullptr, GuardBytes() + StackBytes(),
+                   PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                   -1, 0);
+    ASSERT(p != MAP_FAILED);
+
+    // Stacks grow down, so overflows run into the page below.
+    int status = mprotect(p, GuardBytes(), PROT_NONE);
+    ASSERT(status == 0);
+
+    uintptr_t *stack = (uintptr_t *) ((char *) p + GuardBytes());
+    for (unsigned i = 0; i < STACK_SIZE; i++)
+    {
+        stack[i] = STACK_PAINT;
+    }
+    numMapped++;
+    return stack;
+}
+
+void StackPool::Unmap(uintptr_t *stack)
+{
+    munmap((char *) stack - GuardBytes(), GuardBytes() + StackBytes());
+}
+
+uintptr_t *
+StackPool::Get()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    uintptr_t *stack;
+    if (freeList != nullptr)
+    {
+        stack = freeList;
+        freeList = (uintptr_t *) stack[STACK_SIZE - 1];
+        stack[STACK_SIZE - 1] = STACK_PAINT;
+        numFree--;
+        numReused++;
+    }
+    else
+    {
+        stack = Map();
+    }
+
+    numInUse++;
+    if (numInUse > peakInUse)
+    {
+        peakInUse = numInUse;
+    }
+
+    interrupt->SetLevel(oldLevel);
+    return stack;
+}
+
+/// Only the part of the stack the thread used has to be painted again.
+void StackPool::Put(uintptr_t *stack, const char *owner)
+{
+    ASSERT(stack != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    ASSERT(numInUse > 0);
+    numInUse--;
+
+    // A stack that overflowed is not handed out again: what it holds
+    // cannot be trusted, not even the pattern.
+    if (stack[0] != STACK_FENCEPOST)
+    {
+        DEBUG('t', "Thread \"%s\" overflowed its stack\n", owner);
+        Unmap(stack);
+        interrupt->SetLevel(oldLevel);
+        return;
+    }
+
+    unsigned used = Usage(stack);
+    DEBUG('t', "Thread \"%s\" used %u of %u bytes of stack\n",
+          owner, used, (unsigned) StackBytes());
+    if (used > deepest)
+    {
+        deepest = used;
+        strncpy(deepestOwner, owner, sizeof deepestOwner - 1);
+        deepestOwner[sizeof deepestOwner - 1] = '\0';
+    }
+
+    if (numFree >= maxFree)
+    {
+        Unmap(stack);
+    }
+    else
+    {
+        for (unsigned i = STACK_SIZE - used / sizeof *stack; i < STACK_SIZE;
+             i++)
+        {
+            stack[i] = STACK_PAINT;
+        }
+        stack[STACK_SIZE - 1] = (uintptr_t) freeList;
+        freeList = stack;
+        numFree++;
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void StackPool::SetMaxFree(unsigned maxFree_)
+{
+    maxFree = maxFree_;
+    while (numFree > maxFree)
+    {
+        uintptr_t *stack = freeList;
+        freeList = (uintptr_t *) stack[STACK_SIZE - 1];
+        Unmap(stack);
+        numFree--;
+    }
+}
+
+/// The fencepost at the bottom does not count.
+unsigned
+StackPool::Usage(const uintptr_t *stack)
+{
+    ASSERT(stack != nullptr);
+
+    unsigned i = 1;
+    while (i < STACK_SIZE && stack[i] == STACK_PAINT)
+    {
+        i++;
+    }
+    return (STACK_SIZE - i) * sizeof *stack;
+}
+
+void StackPool::Print() const
+{
+    if (numMapped == 0)
+    {
+        return;
+    }
+    printf("Stacks: mapped %lu, reused %lu, peak in use %u, free %u "
+           "(at most %u)\n", numMapped, numReused, peakInUse, numFree,
+           maxFree);
+    if (deepest > 0)
+    {
+        printf("Deepest stack: %u of %u bytes, by thread \"%s\"\n",
+               deepest, (unsigned) StackBytes(), deepestOwner);
+    }
+}
@@ -0,0 +1,77 @@
+/// Pool of thread execution stacks.
+///
+/// Every stack has an inaccessible guard page just below it, so that a
+/// thread that overflows its stack faults instead of silently writing over
+/// somebody else's memory.  Mapping a stack and protecting its guard page
+/// takes a few system calls, so the stacks of finished threads are kept
+/// and handed out again to new ones, up to a number that can be changed.
+///
+/// Stacks are filled with a pattern before they are handed out; how much
+/// of it a thread overwrote tells how deep its stack got.  That is reported
+/// for every thread that finishes, with the `t` debug flag, and the
+/// deepest one is printed when the machine halts, to help right-size
+/// `STACK_SIZE`.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_STACKPOOL__HH
+#define NACHOS_THREADS_STACKPOOL__HH
+
+#include <stdint.h>
+
+/// Stacks of finished threads kept for reuse, unless changed.
+const unsigned DEFAULT_STACK_POOL_SIZE = 16;
+
+class StackPool
+{
+public:
+    /// * `maxFree` is how many free stacks are kept at most; the stacks
+    ///   given back beyond that are unmapped.
+    StackPool(unsigned maxFree = DEFAULT_STACK_POOL_SIZE);
+
+    /// Unmap the free stacks.
+    ~StackPool();
+
+    /// Return a stack of `STACK_SIZE` words, filled with the pattern.
+    uintptr_t *Get();
+
+    /// Give back the stack of a thread that finished.
+    ///
+    /// * `owner` is the name of the thread, for the report.
+    void Put(uintptr_t *stack, const char *owner);
+
+    void SetMaxFree(unsigned maxFree);
+
+    /// Bytes of `stack` a thread has used so far.
+    static unsigned Usage(const uintptr_t *stack);
+
+    /// Print the counters and the deepest stack seen.
+    void Print() const;
+
+private:
+    /// Map a new stack, with its guard page.
+    uintptr_t *Map();
+
+    void Unmap(uintptr_t *stack);
+
+    /// Free stacks, linked through their last word.
+    uintptr_t *freeList;
+    unsigned numFree;
+    unsigned maxFree;
+
+    /// Stacks mapped, and stacks handed out again.
+    unsigned long numMapped;
+    unsigned long numReused;
+
+    /// Stacks in use, and the most there were at a time.
+    unsigned numInUse;
+    unsigned peakInUse;
+
+    /// Deepest use of a stack, and the thread that got there.
+    unsigned deepest;
+    char deepestOwner[32];
+};
+
+#endif
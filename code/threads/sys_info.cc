@@ -52,9 +52,10 @@ General:\n\
       printf("\n\
 Memory:\n\
   Page size: %u bytes.\n\
-  Number of pages: %u.\n\
+  Default number of pages: %u.\n\
   Number of TLB entries: %u.\n\
-  Memory size: %u bytes.\n", PAGE_SIZE, NUM_PHYS_PAGES, TLB_SIZE, MEMORY_SIZE);
+  Default memory size: %u bytes.\n", PAGE_SIZE, DEFAULT_NUM_PHYS_PAGES, TLB_SIZE,
+      DEFAULT_NUM_PHYS_PAGES * PAGE_SIZE);
       printf("\n\
 Disk:\n\
   Sector size: %u bytes.\n\
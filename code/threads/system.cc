@@ -14,6 +14,7 @@
 #include "userprog/exception.hh"
 #endif
 
+#include <ctype.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -25,15 +26,22 @@
 Thread* currentThread;        ///< The thread we are running now.
 Thread* threadToBeDestroyed;  ///< The thread that just finished.
 Scheduler* scheduler;         ///< The ready list.
+StackPool* stackPool;         ///< Stacks of finished threads, for reuse.
 Interrupt* interrupt;         ///< Interrupt status.
 Statistics* stats;            ///< Performance metrics.
 Timer* timer;                 ///< The hardware timer device, for invoking
 ///< context switches.
+TimerWheel* timerWheel;       ///< Timers of the kernel, for sleeping and
+                              ///< timed waits.
+LockProfiler* lockProfiler;   ///< Contention on every lock, when asked for.
 
 // 2007, Jose Miguel Santos Espino
 PreemptiveScheduler* preemptiveScheduler = nullptr;
 const long long DEFAULT_TIME_SLICE = 50000;
 
+/// Time slice of the signal preemption backend, in microseconds.
+const long long DEFAULT_SIGNAL_TIME_SLICE = 10000;
+
 // #define FILESYS_NEEDED 1 
 
 #ifdef FILESYS_NEEDED
@@ -47,7 +55,13 @@ SynchDisk* synchDisk;
 #ifdef USER_PROGRAM  // Requires either *FILESYS* or *FILESYS_STUB*.
 Machine* machine;  ///< User program memory and registers.
 SynchConsole* synchConsole;
-Bitmap* pageMap;
+CoreMap* coreMap;
+SharedMemory* sharedMemory;
+PageDeduplicator* pageDeduplicator;
+#ifdef VMEM
+WorkingSetManager* workingSetManager;
+CompressedCache* compressedCache;
+#endif
 Table<Thread*>* threadsTable;
 #endif
 
@@ -75,11 +89,32 @@ extern void Cleanup();
 static void
 TimerInterruptHandler(void* dummy)
 {
-    if (interrupt->GetStatus() != IDLE_MODE) {
+    if (interrupt->GetStatus() != IDLE_MODE && scheduler->TimerExpired()) {
         interrupt->YieldOnReturn();
     }
 }
 
+/// Names of the scheduling policies, for `-sp`.
+static const char* POLICY_NAMES[] = { "priority", "mlfq", "fair" };
+static_assert(sizeof POLICY_NAMES / sizeof POLICY_NAMES[0]
+                == NUM_SCHEDULING_POLICIES,
+              "Every scheduling policy needs a name.");
+
+static bool
+ParsePolicy(const char* s, SchedulingPolicy* out)
+{
+    ASSERT(s != nullptr);
+    ASSERT(out != nullptr);
+
+    for (unsigned i = 0; i < NUM_SCHEDULING_POLICIES; i++) {
+        if (strcmp(s, POLICY_NAMES[i]) == 0) {
+            *out = (SchedulingPolicy) i;
+            return true;
+        }
+    }
+    return false;
+}
+
 static bool
 ParseDebugOpts(char* s, DebugOpts* out)
 {
@@ -138,14 +173,25 @@ Initialize(int argc, char** argv)
     const char* debugFlags = "";
     DebugOpts debugOpts;
     bool randomYield = false;
+    SchedulingPolicy policy = POLICY_PRIORITY;
+    unsigned stacksKept = DEFAULT_STACK_POOL_SIZE;
+    bool profileLocks = false;
 
     // 2007, Jose Miguel Santos Espino
     bool preemptiveScheduling = false;
+    PreemptionBackend preemptionBackend = PREEMPT_SIGNAL;
     long long timeSlice;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = false;  // Single step user program.
-    pageMap = new Bitmap(NUM_PHYS_PAGES);
+    bool deduplicatePages = false;  // Merge identical frames.
+    unsigned numPhysPages = DEFAULT_NUM_PHYS_PAGES;
+    const char *tracePath = nullptr;  // Host file for memory accesses.
+#ifdef VMEM
+    // Frames given to the compressed cache.
+    unsigned cacheFrames = DEFAULT_COMPRESSED_CACHE_FRAMES;
+#endif
+    sharedMemory = new SharedMemory();
     threadsTable = new Table<Thread*>();
     // synchConsole = new SynchConsole(NULL, NULL);
 #endif
@@ -181,11 +227,27 @@ Initialize(int argc, char** argv)
             randomYield = true;
             argCount = 2;
         }
+        else if (!strcmp(*argv, "-sp")) {
+            ASSERT(argc > 1);
+            ASSERT(ParsePolicy(*(argv + 1), &policy));
+            argCount = 2;
+        }
+        else if (!strcmp(*argv, "-sk")) {
+            ASSERT(argc > 1);
+            stacksKept = atoi(*(argv + 1));
+            argCount = 2;
+        }
+        else if (!strcmp(*argv, "-lp")) {
+            profileLocks = true;
+        }
         // 2007, Jose Miguel Santos Espino
-        else if (!strcmp(*argv, "-p")) {
+        else if (!strcmp(*argv, "-p") || !strcmp(*argv, "-pt")) {
             preemptiveScheduling = true;
-            if (argc == 1) {
-                timeSlice = DEFAULT_TIME_SLICE;
+            bool ptrace = !strcmp(*argv, "-pt");
+            preemptionBackend = ptrace ? PREEMPT_PTRACE : PREEMPT_SIGNAL;
+            if (argc == 1 || !isdigit(argv[1][0])) {
+                timeSlice = ptrace ? DEFAULT_TIME_SLICE
+                                   : DEFAULT_SIGNAL_TIME_SLICE;
             }
             else {
                 timeSlice = atoi(*(argv + 1));
@@ -196,6 +258,27 @@ Initialize(int argc, char** argv)
         if (!strcmp(*argv, "-s")) {
             debugUserProg = true;
         }
+        else if (!strcmp(*argv, "-dp")) {
+            deduplicatePages = true;
+        }
+#ifdef VMEM
+        else if (!strcmp(*argv, "-cc")) {
+            ASSERT(argc > 1);
+            cacheFrames = atoi(*(argv + 1));
+            argCount = 2;
+        }
+#endif
+        else if (!strcmp(*argv, "-m")) {
+            ASSERT(argc > 1);
+            numPhysPages = atoi(*(argv + 1));
+            ASSERT(numPhysPages > 0 && numPhysPages <= MAX_NUM_PHYS_PAGES);
+            argCount = 2;
+        }
+        else if (!strcmp(*argv, "-mt")) {
+            ASSERT(argc > 1);
+            tracePath = *(argv + 1);
+            argCount = 2;
+        }
 #endif
 #ifdef FILESYS_NEEDED
         if (!strcmp(*argv, "-f")) {
@@ -219,8 +302,12 @@ Initialize(int argc, char** argv)
     debug.SetFlags(debugFlags);  // Initialize `DEBUG` messages.
     debug.SetOpts(debugOpts);    // Set debugging behavior.
     stats = new Statistics;      // Collect statistics.
+    // Before any lock is created, so that all of them are counted.
+    lockProfiler = profileLocks ? new LockProfiler : nullptr;
     interrupt = new Interrupt;   // Start up interrupt handling.
-    scheduler = new Scheduler;   // Initialize the ready queue.
+    scheduler = new Scheduler(policy);  // Initialize the ready queue.
+    stackPool = new StackPool(stacksKept);
+    timerWheel = new TimerWheel;
     if (randomYield) {           // Start the timer (if needed).
         timer = new Timer(TimerInterruptHandler, 0, randomYield);
     }
@@ -240,7 +327,7 @@ Initialize(int argc, char** argv)
     // Jose Miguel Santos Espino, 2007
     if (preemptiveScheduling) {
         preemptiveScheduler = new PreemptiveScheduler();
-        preemptiveScheduler->SetUp(timeSlice);
+        preemptiveScheduler->SetUp(timeSlice, preemptionBackend);
     }
 
 #ifdef USER_PROGRAM
@@ -250,8 +337,25 @@ Initialize(int argc, char** argv)
     }
 #endif
     Debugger* d = debugUserProg ? new Debugger : nullptr;
-    machine = new Machine(d);  // This must come first.
+    machine = new Machine(d, numPhysPages);  // This must come first.
+    coreMap = new CoreMap(numPhysPages);
+    if (tracePath != nullptr) {
+        machine->GetMMU()->StartTrace(tracePath);
+    }
     SetExceptionHandlers();
+    if (deduplicatePages) {
+        pageDeduplicator = new PageDeduplicator();
+        pageDeduplicator->Start();
+    }
+    else {
+        pageDeduplicator = nullptr;
+    }
+#ifdef VMEM
+    workingSetManager = new WorkingSetManager();
+    ASSERT(cacheFrames < numPhysPages);
+    compressedCache = cacheFrames > 0 ? new CompressedCache(cacheFrames)
+                                      : nullptr;
+#endif
 #endif
 
 #ifdef FILESYS
@@ -284,6 +388,13 @@ Cleanup()
     delete machine;
     delete synchConsole;
     delete threadsTable;
+    delete pageDeduplicator;
+#ifdef VMEM
+    delete workingSetManager;
+    delete compressedCache;
+#endif
+    delete sharedMemory;
+    delete coreMap;
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -295,8 +406,11 @@ Cleanup()
 #endif
 
     delete timer;
+    delete timerWheel;
     delete scheduler;
+    delete stackPool;
     delete interrupt;
+    delete lockProfiler;
 
     exit(0);
 }
@@ -10,6 +10,9 @@
 
 #include "thread.hh"
 #include "scheduler.hh"
+#include "stack_pool.hh"
+#include "lock_profiler.hh"
+#include "timer_wheel.hh"
 #include "lib/utility.hh"
 #include "machine/interrupt.hh"
 #include "machine/statistics.hh"
@@ -30,21 +33,36 @@ extern void Cleanup();
 extern Thread *currentThread;       ///< The thread holding the CPU.
 extern Thread *threadToBeDestroyed; ///< The thread that just finished.
 extern Scheduler *scheduler;        ///< The ready list.
+extern StackPool *stackPool;        ///< Stacks of finished threads.
 extern Interrupt *interrupt;        ///< Interrupt status.
 extern Statistics *stats;           ///< Performance metrics.
 extern Timer *timer;                ///< The hardware alarm clock.
+extern TimerWheel *timerWheel;      ///< Timers of the kernel.
+extern LockProfiler *lockProfiler;  ///< Lock contention; null unless
+                                    ///< enabled.
 
 #ifdef USER_PROGRAM
 #include "userprog/synch_console.hh"
 #include "machine/machine.hh"
-#include "lib/bitmap.hh"
+#include "userprog/core_map.hh"
+#include "userprog/page_dedup.hh"
+#include "userprog/shared_memory.hh"
 #include "lib/table.hh"
 
 class SynchConsole;
 
 extern Machine *machine; // User program memory and registers.
 extern SynchConsole *synchConsole; // Console used in syscall testing
-extern Bitmap *pageMap;
+extern CoreMap *coreMap;  // Physical frames in use.
+extern SharedMemory *sharedMemory;  // Named shared-memory segments.
+extern PageDeduplicator *pageDeduplicator;  // Null unless enabled.
+
+#ifdef VMEM
+#include "vmem/working_set.hh"
+#include "vmem/compressed_cache.hh"
+extern WorkingSetManager *workingSetManager;
+extern CompressedCache *compressedCache;  // Null unless enabled.
+#endif
 extern Table<Thread*> *threadsTable;
 
 #endif
@@ -24,10 +24,6 @@
 #include <inttypes.h>
 #include <stdio.h>
 
-/// This is put at the top of the execution stack, for detecting stack
-/// overflows.
-const unsigned STACK_FENCEPOST = 0xDEADBEEF;
-
 static inline bool
 IsThreadStatus(ThreadStatus s)
 {
@@ -46,6 +42,8 @@ Thread::Thread(const char *threadName, bool joinable_, int priority_)
     joinable = joinable_;
     priority = priority_;
     realPriority = priority;
+    heldLocks = nullptr;
+    waitingOn = nullptr;
     stackTop = nullptr;
     stack = nullptr;
     status = JUST_CREATED;
@@ -59,6 +57,13 @@ Thread::Thread(const char *threadName, bool joinable_, int priority_)
     }
 
     space = nullptr;
+    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++)
+    {
+        userRegisters[i] = 0;
+    }
+#ifdef VMEM
+    suspended = false;
+#endif
 #endif
     if (joinable)
     {
@@ -85,38 +90,65 @@ Thread::~Thread()
     ASSERT(this != currentThread);
     if (stack != nullptr)
     {
-        SystemDep::DeallocBoundedArray((char *)stack,
-                                       STACK_SIZE * sizeof *stack);
+        stackPool->Put(stack, name);
     }
     if (channel != nullptr)
     {
         delete channel;
     }
 #ifdef USER_PROGRAM
+    // The address space goes first, because mapped files are written back
+    // when it is destroyed.
+    if (space != nullptr)
+    {
+        delete space;
+    }
+
     // First two open files reserved for console purposes.
-    for (unsigned i = 2; !fileTable->IsEmpty() && fileTable->HasKey(i); i++)
+    for (unsigned i = 2; i < fileTable->GetCapacity(); i++)
     {
-        DEBUG('t', "Removing file %u.\n", i);
-        OpenFile *file = fileTable->Remove(i);
-        delete file;
+        if (fileTable->HasKey(i))
+        {
+            DEBUG('t', "Removing file %u.\n", i);
+            delete fileTable->Remove(i);
+        }
     }
 
     delete fileTable;
     threadsTable->Remove(spaceId);
-    if (space != nullptr)
+
+    if (machine->GetRegisters() == userRegisters)
     {
-        delete space;
+        machine->SetRegisterFile(nullptr);
     }
 #endif
     delete[] name;
 }
 
 #ifdef USER_PROGRAM
+/// A thread that gets an address space while running, like the main one,
+/// starts using its own registers right away.
 int Thread::SetAddressSpace(AddressSpace *space_)
 {
     space = space_;
+    if (this == currentThread)
+    {
+        RestoreUserState();
+    }
     return spaceId;
 }
+
+#ifdef VMEM
+bool Thread::IsSuspended() const
+{
+    return suspended;
+}
+
+void Thread::SetSuspended(bool value)
+{
+    suspended = value;
+}
+#endif
 #endif
 
 int Thread::Join()
@@ -201,12 +233,24 @@ void Thread::CheckOverflow() const
     }
 }
 
+unsigned
+Thread::GetStackUsage() const
+{
+    return stack != nullptr ? StackPool::Usage(stack) : 0;
+}
+
 void Thread::SetStatus(ThreadStatus st)
 {
     ASSERT(IsThreadStatus(st));
     status = st;
 }
 
+ThreadStatus
+Thread::GetStatus() const
+{
+    return status;
+}
+
 const char *
 Thread::GetName() const
 {
@@ -232,6 +276,14 @@ void Thread::Print() const
 void Thread::Finish(int _status)
 {
     DEBUG('t', "Finishing thread \"%s\"\n", GetName());
+#ifdef USER_PROGRAM
+    // Write back the mapped files now: the thread may never be deleted,
+    // if the machine halts first, and whoever joins it may read them.
+    if (space != nullptr)
+    {
+        space->UnmapAll();
+    }
+#endif
     if (joinable)
     {
         DEBUG('d', "Thread is joinable\n");
@@ -269,6 +321,23 @@ void Thread::Yield()
 
     DEBUG('t', "Yielding thread \"%s\"\n", GetName());
 
+#ifdef VMEM
+    if (IsSuspended())
+    {
+        // Park until the working set manager resumes this thread, even if
+        // nobody else can run meanwhile.
+        scheduler->ReadyToRun(this);
+        Thread *nextThread;
+        while ((nextThread = scheduler->FindNextToRun()) == nullptr)
+        {
+            scheduler->Idle();
+        }
+        scheduler->Run(nextThread);
+        interrupt->SetLevel(oldLevel);
+        return;
+    }
+#endif
+
     Thread *nextThread = scheduler->FindNextToRun();
     if (nextThread != nullptr)
     {
@@ -287,7 +356,7 @@ void Thread::Yield()
 /// ready queue, so that it can be re-scheduled.
 ///
 /// NOTE: if there are no threads on the ready queue, that means we have no
-/// thread to run.  `Interrupt::Idle` is called to signify that we should
+/// thread to run.  `Scheduler::Idle` is called to signify that we should
 /// idle the CPU until the next I/O interrupt occurs (the only thing that
 /// could cause a thread to become ready to run).
 ///
@@ -306,12 +375,42 @@ void Thread::Sleep()
     status = BLOCKED;
     while ((nextThread = scheduler->FindNextToRun()) == nullptr)
     {
-        interrupt->Idle(); // No one to run, wait for an interrupt.
+        scheduler->Idle(); // No one to run, wait for an interrupt.
     }
 
     scheduler->Run(nextThread); // Returns when we have been signalled.
 }
 
+/// Timer handler for `Thread::SleepFor`.
+static void
+WakeUp(void *arg)
+{
+    scheduler->ReadyToRun((Thread *) arg);
+}
+
+/// The thread waits on a timer of the `timerWheel`, so it takes no CPU
+/// meanwhile.  The timer lives on the stack of the thread, which stays put
+/// while it sleeps.
+void Thread::SleepFor(unsigned long ticks)
+{
+    ASSERT(this == currentThread);
+
+    if (ticks == 0)
+    {
+        return;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    DEBUG('t', "Thread \"%s\" sleeps for %lu ticks\n", GetName(), ticks);
+
+    TimerEntry alarm;
+    timerWheel->Start(&alarm, ticks, WakeUp, this);
+    Sleep();
+
+    interrupt->SetLevel(oldLevel);
+}
+
 /// ThreadFinish, InterruptEnable
 ///
 /// Dummy functions because C++ does not allow a pointer to a member
@@ -323,9 +422,17 @@ ThreadFinish()
     currentThread->Finish();
 }
 
+/// A new thread does not get to the end of `Scheduler::Run`, so it
+/// restores its user state here.
 static void
 InterruptEnable()
 {
+#ifdef USER_PROGRAM
+    if (currentThread->space != nullptr)
+    {
+        currentThread->RestoreUserState();
+    }
+#endif
     interrupt->Enable();
 }
 
@@ -343,8 +450,7 @@ void Thread::StackAllocate(VoidFunctionPtr func, void *arg)
 {
     ASSERT(func != nullptr);
 
-    stack = (uintptr_t *)
-        SystemDep::AllocBoundedArray(STACK_SIZE * sizeof *stack);
+    stack = stackPool->Get();
 
     // Stacks in x86 work from high addresses to low addresses.
     stackTop = stack + STACK_SIZE - 4; // -4 to be on the safe side!
@@ -384,29 +490,24 @@ OpenFile *Thread::GetFile(int fileId)
     return fileTable->Get(fileId);
 }
 
-/// Save the CPU state of a user program on a context switch.
-///
-/// Note that a user program thread has *two* sets of CPU registers -- one
-/// for its state while executing user code, one for its state while
-/// executing kernel code.  This routine saves the former.
-void Thread::SaveUserState()
-{
-    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++)
-    {
-        userRegisters[i] = machine->ReadRegister(i);
-    }
-}
-
 /// Restore the CPU state of a user program on a context switch.
 ///
 /// Note that a user program thread has *two* sets of CPU registers -- one
 /// for its state while executing user code, one for its state while
-/// executing kernel code.  This routine restores the former.
+/// executing kernel code.  The former stay in `userRegisters`, which the
+/// machine uses in place while the thread runs, so there is nothing to
+/// save when it is switched out, and nothing to copy here.
+///
+/// The address space is installed too, unless it still is.  Then its TLB
+/// entries are kept as well: whatever changed its page table meanwhile
+/// (eviction, swapping, deduplication) dropped the ones it made stale, with
+/// `AddressSpace::InvalidatePage`.
 void Thread::RestoreUserState()
 {
-    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++)
+    machine->SetRegisterFile(userRegisters);
+    if (space != nullptr && !space->IsLoaded())
     {
-        machine->WriteRegister(i, userRegisters[i]);
+        space->RestoreState();
     }
 }
 
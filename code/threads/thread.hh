@@ -39,6 +39,8 @@
 #define NACHOS_THREADS_THREAD__HH
 
 #include "lib/utility.hh"
+#include "lib/intrusive_list.hh"
+#include "lib/slab.hh"
 
 // #define USER_PROGRAM 1
 
@@ -52,15 +54,23 @@
 #include <stdint.h>
 
 class Channel;
+class Lock;
 
 const int MAX_PRIORITY = 10;
 
+/// Weight of a thread under the fair scheduling policy, unless changed.
+const unsigned DEFAULT_WEIGHT = 1024;
+
 /// CPU register state to be saved on context switch.
 ///
 /// x86 processors needs 9 32-bit registers, whereas x64 has 8 extra
 /// registers.  We allocate room for the maximum of these two architectures.
 const unsigned MACHINE_STATE_SIZE = 17;
 
+/// This is put at the top of the execution stack, for detecting stack
+/// overflows.
+const unsigned STACK_FENCEPOST = 0xDEADBEEF;
+
 /// Size of the thread's private execution stack.
 ///
 /// In words.
@@ -78,6 +88,56 @@ enum ThreadStatus
     NUM_THREAD_STATUS
 };
 
+/// What the scheduler keeps track of about a thread, besides its priority.
+struct SchedulingState
+{
+    /// Multilevel feedback queue level; 0 is the top one.
+    unsigned level = 0;
+
+    /// Ticks run since the thread got to its level.
+    unsigned long used = 0;
+
+    /// Priority reset period the level belongs to; levels of earlier
+    /// periods no longer count.
+    unsigned epoch = 0;
+
+    /// Share of the CPU under the fair policy, relative to the weights of
+    /// the other threads.
+    unsigned weight = DEFAULT_WEIGHT;
+
+    /// Ticks run, scaled by `DEFAULT_WEIGHT / weight` and in fixed point;
+    /// the fair policy runs the ready thread that is furthest behind.
+    unsigned long long vruntime = 0;
+
+    /// Ticks run in total.
+    unsigned long runTime = 0;
+
+    /// Position in the heap of the fair ready queue, -1 if not on it.
+    int heapIndex = -1;
+
+    /// Order of arrival to a heap of ready threads, to break ties.
+    unsigned long seq = 0;
+
+    /// Real-time reservation: `budget` ticks of CPU every `period` ticks.
+    /// A budget of 0 means the thread is not real time.
+    unsigned long period = 0;
+    unsigned long budget = 0;
+
+    /// Budget left in the current period.
+    unsigned long remaining = 0;
+
+    /// Start of the current period, and its end, by which the job of the
+    /// period should be done.
+    unsigned long release = 0;
+    unsigned long long deadline = 0;
+
+    /// Jobs done, jobs done after their deadline, and periods in which the
+    /// budget ran out.
+    unsigned long jobs = 0;
+    unsigned long missed = 0;
+    unsigned long overruns = 0;
+};
+
 /// The following class defines a “thread control block” -- which represents
 /// a single thread of execution.
 ///
@@ -106,6 +166,8 @@ private:
     int realPriority;
 
 public:
+    SLAB_ALLOCATED(Thread)
+
     /// Initialize a `Thread`.
     Thread(const char *debugName, bool joinable = false, int priority = MAX_PRIORITY);
 
@@ -126,6 +188,9 @@ public:
     /// Put the thread to sleep and relinquish the processor.
     void Sleep();
 
+    /// Sleep until `ticks` ticks of simulated time have gone by.
+    void SleepFor(unsigned long ticks);
+
     int Join();
 
     /// The thread is done executing.
@@ -134,8 +199,14 @@ public:
     /// Check if thread has overflowed its stack.
     void CheckOverflow() const;
 
+    /// Bytes of its stack the thread has used so far; 0 for the main
+    /// thread, whose stack is the one of the host.
+    unsigned GetStackUsage() const;
+
     void SetStatus(ThreadStatus st);
 
+    ThreadStatus GetStatus() const;
+
     const char *GetName() const;
 
     void Print() const;
@@ -145,6 +216,24 @@ public:
     void SetPriority(int priority);
     void ResetPriority();
 
+    /// Link for the queue the thread waits on: a ready list while it is
+    /// ready, a semaphore queue while it is blocked.
+    ListLink<Thread> queueLink;
+
+#ifdef VMEM
+    /// Link for the list of suspended threads.
+    ListLink<Thread> suspendLink;
+#endif
+
+    /// Owned by the `Scheduler`.
+    SchedulingState sched;
+
+    /// Locks the thread holds, linked through `Lock::nextHeld`, and the one
+    /// it waits to acquire, if any.  Owned by `Lock`, which follows them to
+    /// pass priorities on.
+    Lock *heldLocks;
+    Lock *waitingOn;
+
 private:
     // Some of the private data for this class is listed above.
 
@@ -183,19 +272,34 @@ public:
 
     OpenFile *GetFile(int fileId);
 
-    // Save user-level register state.
-    void SaveUserState();
-
-    // Restore user-level register state.
+    /// Make the machine run on the user-level registers and the address
+    /// space of this thread.
     void RestoreUserState();
 
     // User code this thread is running.
     AddressSpace *space;
 
     int SetAddressSpace(AddressSpace *space);
+
+#ifdef VMEM
+    /// Whether the working set manager keeps the thread from running.
+    bool IsSuspended() const;
+    void SetSuspended(bool value);
+
+private:
+    bool suspended;
+#endif
     #endif
 };
 
+/// Threads waiting in line, linked through `Thread::queueLink`.
+typedef IntrusiveList<Thread, &Thread::queueLink> ThreadQueue;
+
+#ifdef VMEM
+/// Suspended threads, linked through `Thread::suspendLink`.
+typedef IntrusiveList<Thread, &Thread::suspendLink> SuspendedQueue;
+#endif
+
 /// Magical machine-dependent routines, defined in `switch.s`.
 
 extern "C"
@@ -0,0 +1,165 @@
+/// Routines to manage the heap of threads that are ready to run.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_heap.hh"
+
+/// Room the heap starts with.
+static const unsigned INITIAL_CAPACITY = 16;
+
+ThreadHeap::ThreadHeap(unsigned long long SchedulingState::*key_)
+{
+    key = key_;
+    capacity = INITIAL_CAPACITY;
+    heap = new Thread *[capacity];
+    size = 0;
+    nextSeq = 0;
+}
+
+/// The threads themselves are not de-allocated.
+ThreadHeap::~ThreadHeap()
+{
+    for (unsigned i = 0; i < size; i++)
+    {
+        heap[i]->sched.heapIndex = -1;
+    }
+    delete [] heap;
+}
+
+void ThreadHeap::Insert(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+    ASSERT(thread->sched.heapIndex == -1);
+
+    if (size == capacity)
+    {
+        Grow();
+    }
+    thread->sched.seq = nextSeq++;
+    thread->sched.heapIndex = size;
+    heap[size] = thread;
+    size++;
+    SiftUp(size - 1);
+}
+
+Thread *
+ThreadHeap::Top() const
+{
+    return size > 0 ? heap[0] : nullptr;
+}
+
+Thread *
+ThreadHeap::Pop()
+{
+    Thread *thread = Top();
+    if (thread != nullptr)
+    {
+        Remove(thread);
+    }
+    return thread;
+}
+
+bool ThreadHeap::Remove(Thread *thread)
+{
+    if (!Has(thread))
+    {
+        return false;
+    }
+
+    unsigned i = thread->sched.heapIndex;
+    size--;
+    if (i != size)
+    {
+        // Fill the hole with the last thread, which may belong either
+        // above or below it.
+        Swap(i, size);
+        SiftUp(i);
+        SiftDown(i);
+    }
+    thread->sched.heapIndex = -1;
+    return true;
+}
+
+bool ThreadHeap::Has(Thread *thread) const
+{
+    ASSERT(thread != nullptr);
+
+    int i = thread->sched.heapIndex;
+    return i >= 0 && (unsigned) i < size && heap[i] == thread;
+}
+
+bool ThreadHeap::IsEmpty() const
+{
+    return size == 0;
+}
+
+void ThreadHeap::Apply(void (*func)(Thread *)) const
+{
+    ASSERT(func != nullptr);
+
+    for (unsigned i = 0; i < size; i++)
+    {
+        func(heap[i]);
+    }
+}
+
+bool ThreadHeap::Before(unsigned i, unsigned j) const
+{
+    const SchedulingState &a = heap[i]->sched, &b = heap[j]->sched;
+    return a.*key < b.*key || (a.*key == b.*key && a.seq < b.seq);
+}
+
+void ThreadHeap::Swap(unsigned i, unsigned j)
+{
+    Thread *t = heap[i];
+    heap[i] = heap[j];
+    heap[j] = t;
+    heap[i]->sched.heapIndex = i;
+    heap[j]->sched.heapIndex = j;
+}
+
+void ThreadHeap::SiftUp(unsigned i)
+{
+    while (i > 0 && Before(i, (i - 1) / 2))
+    {
+        Swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+void ThreadHeap::SiftDown(unsigned i)
+{
+    for (;;)
+    {
+        unsigned first = i;
+        unsigned left = 2 * i + 1, right = 2 * i + 2;
+        if (left < size && Before(left, first))
+        {
+            first = left;
+        }
+        if (right < size && Before(right, first))
+        {
+            first = right;
+        }
+        if (first == i)
+        {
+            return;
+        }
+        Swap(i, first);
+        i = first;
+    }
+}
+
+void ThreadHeap::Grow()
+{
+    Thread **newHeap = new Thread *[2 * capacity];
+    for (unsigned i = 0; i < size; i++)
+    {
+        newHeap[i] = heap[i];
+    }
+    delete [] heap;
+    heap = newHeap;
+    capacity *= 2;
+}
@@ -0,0 +1,77 @@
+/// Queue of threads that are ready to run, by some key of theirs.
+///
+/// A binary min-heap ordered by one of the fields of `SchedulingState`,
+/// such as the virtual runtime or the deadline, and by order of arrival
+/// among threads with the same key.  Every thread keeps its
+/// position in the heap, so that taking an arbitrary one out takes
+/// logarithmic time like everything else.  The array only grows, so that
+/// once it has room for every thread, nothing touches the heap.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_THREADHEAP__HH
+#define NACHOS_THREADS_THREADHEAP__HH
+
+#include "thread.hh"
+
+class ThreadHeap
+{
+public:
+    /// Order threads by their `key` field.
+    ThreadHeap(unsigned long long SchedulingState::*key);
+
+    ~ThreadHeap();
+
+    /// Put `thread` in the queue, with the current value of its key.
+    void Insert(Thread *thread);
+
+    /// The thread with the lowest key, which stays in the queue.
+    ///
+    /// Returns null if the queue is empty.
+    Thread *Top() const;
+
+    /// Take the thread with the lowest key.
+    ///
+    /// Returns null if there is none.
+    Thread *Pop();
+
+    /// Take `thread` out of the queue.
+    ///
+    /// Returns whether it was on it.
+    bool Remove(Thread *thread);
+
+    /// Is `thread` on the queue?
+    bool Has(Thread *thread) const;
+
+    bool IsEmpty() const;
+
+    /// Apply `func` to every thread, in no particular order.
+    void Apply(void (*func)(Thread *)) const;
+
+private:
+    /// Should the thread at `i` run before the one at `j`?
+    bool Before(unsigned i, unsigned j) const;
+
+    /// Exchange the threads at `i` and `j`, keeping their positions.
+    void Swap(unsigned i, unsigned j);
+
+    /// Move the thread at `i` up or down until the heap is in order.
+    void SiftUp(unsigned i);
+    void SiftDown(unsigned i);
+
+    /// Double the room of the array.
+    void Grow();
+
+    unsigned long long SchedulingState::*key;
+
+    Thread **heap;
+    unsigned size;
+    unsigned capacity;
+
+    /// Arrival counter.
+    unsigned long nextSeq;
+};
+
+#endif
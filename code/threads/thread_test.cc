@@ -16,6 +16,13 @@
 #include "thread_test_garden_semaphore.hh"
 #include "thread_test_channels.hh"
 #include "thread_test_priority_inversion.hh"
+#include "thread_test_queues.hh"
+#include "thread_test_mlfq.hh"
+#include "thread_test_fair.hh"
+#include "thread_test_edf.hh"
+#include "thread_test_timers.hh"
+#include "thread_test_inheritance.hh"
+#include "thread_test_rwlock.hh"
 #include "lib/utility.hh"
 
 #include <stdio.h>
@@ -35,7 +42,14 @@ static const Test TESTS[] = {
     {&ThreadTestGardenSemaphore, "garden semaphore", "Ornamental garden with sempahores"},
     {&ThreadTestChannels, "channels", "Test for channels"},
     {&ThreadTestProdCons, "prodcons", "Producer/Consumer"},
-    {&ThreadTestPriorityInversion, "inversion", "Priority inversion problem"}};
+    {&ThreadTestPriorityInversion, "inversion", "Priority inversion problem"},
+    {&ThreadTestQueues, "queues", "Allocations made by the kernel queues"},
+    {&ThreadTestMlfq, "mlfq", "Response time among CPU bound threads"},
+    {&ThreadTestFair, "fair", "CPU shares of threads of different weights"},
+    {&ThreadTestEdf, "edf", "Periodic real-time threads among CPU bound ones"},
+    {&ThreadTestTimers, "timers", "Sleeping threads and timed waits"},
+    {&ThreadTestInheritance, "inheritance", "Priority inheritance down a chain of locks"},
+    {&ThreadTestRWLock, "rwlock", "Reader-writer locks and barriers"}};
 static const unsigned NUM_TESTS = sizeof TESTS / sizeof TESTS[0];
 
 static const unsigned NAME_MAX_LEN = 32;
@@ -0,0 +1,147 @@
+/// Periodic real-time threads among CPU bound ones.
+///
+/// Two threads do a job of a given length every period, like a network
+/// delivery thread and a periodic flush would, while some other threads
+/// just burn CPU.  The periodic ones reserve a budget a bit larger than
+/// their jobs, and a third one asks for more than what is left, which
+/// admission control should refuse.  Each periodic thread prints how many
+/// of its jobs were done after their deadline, which should be none.
+///
+/// Then the periodic threads run again with nothing else to run: the
+/// machine idles between their periods, and should neither halt nor drop
+/// them.  Run it with `-rs` so that there is time slicing.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_edf.hh"
+#include "system.hh"
+
+#include "semaphore.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+/// CPU bound threads in each round.
+static const unsigned HOGS[] = { 2, 0 };
+static const unsigned NUM_ROUNDS = sizeof HOGS / sizeof HOGS[0];
+
+/// A periodic thread: every `period` ticks it needs `work` ticks of CPU,
+/// and reserves `budget`.
+struct Periodic
+{
+    const char *name;
+    unsigned long period;
+    unsigned long budget;
+    unsigned long work;
+    unsigned jobs;
+};
+
+static const Periodic PERIODIC[] = {
+    {"delivery", 1000, 250, 150, 40},
+    {"flush", 4000, 1000, 600, 10}
+};
+static const unsigned NUM_PERIODIC = sizeof PERIODIC / sizeof PERIODIC[0];
+
+static Semaphore *done;
+
+/// Periodic threads still running.
+static unsigned running;
+
+static void
+RunPeriodic(void *arg)
+{
+    const Periodic *p = (const Periodic *) arg;
+
+    for (unsigned i = 0; i < p->jobs; i++) {
+        // Every time interrupts are enabled, `SYSTEM_TICK` ticks go by.
+        for (unsigned long t = 0; t < p->work; t += SYSTEM_TICK) {
+            interrupt->SetLevel(INT_OFF);
+            interrupt->SetLevel(INT_ON);
+        }
+        IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+        scheduler->WaitForNextPeriod();
+        interrupt->SetLevel(oldLevel);
+    }
+
+    const SchedulingState *s = &currentThread->sched;
+    printf("%s: %lu jobs, %lu after their deadline, %lu budget overruns.\n",
+           currentThread->GetName(), s->jobs, s->missed, s->overruns);
+    running--;
+    done->V();
+}
+
+static void
+Hog(void *arg)
+{
+    while (running > 0) {
+        // Let simulated time go by.
+        interrupt->SetLevel(INT_OFF);
+        interrupt->SetLevel(INT_ON);
+    }
+    done->V();
+}
+
+/// Threads own their names.
+static Thread *
+NewThread(const char *threadName)
+{
+    char *name = new char [strlen(threadName) + 1];
+    strcpy(name, threadName);
+    return new Thread(name);
+}
+
+/// Run the periodic threads, along with `numHogs` CPU bound ones.
+static void
+RunRound(unsigned numHogs)
+{
+    printf("With %u CPU bound threads:\n", numHogs);
+    running = NUM_PERIODIC;
+
+    Thread *periodic[NUM_PERIODIC];
+    for (unsigned i = 0; i < NUM_PERIODIC; i++) {
+        const Periodic *p = &PERIODIC[i];
+        periodic[i] = NewThread(p->name);
+        bool admitted = scheduler->SetRealTime(periodic[i], p->period,
+                                               p->budget);
+        ASSERT(admitted);
+    }
+
+    // 25% and 25% are reserved; another 50% does not fit.
+    Thread *greedy = NewThread("greedy");
+    if (scheduler->SetRealTime(greedy, 1000, 500)) {
+        printf("Thread greedy was admitted, and should not be.\n");
+    } else {
+        printf("Thread greedy was refused, as it should.\n");
+    }
+    delete greedy;
+
+    for (unsigned i = 0; i < numHogs; i++) {
+        char name[16];
+        sprintf(name, "hog %u", i);
+        NewThread(name)->Fork(Hog, nullptr);
+    }
+    for (unsigned i = 0; i < NUM_PERIODIC; i++) {
+        periodic[i]->Fork(RunPeriodic, (void *) &PERIODIC[i]);
+    }
+
+    for (unsigned i = 0; i < numHogs + NUM_PERIODIC; i++) {
+        done->P();
+    }
+}
+
+void
+ThreadTestEdf()
+{
+    if (timer == nullptr) {
+        printf("There is no time slicing; run with `-rs`.\n");
+        return;
+    }
+
+    done = new Semaphore("done", 0);
+    for (unsigned i = 0; i < NUM_ROUNDS; i++) {
+        RunRound(HOGS[i]);
+    }
+    delete done;
+}
@@ -0,0 +1,136 @@
+/// Shares of the CPU of CPU bound threads of different weights.
+///
+/// Some threads just burn CPU, each with a different weight.  As simulated
+/// time goes by, the test prints the share of the CPU each one got so far
+/// next to the one its weight entitles it to, and at the end how far off
+/// the furthest one is.  Run it with `-rs` so that there is time slicing,
+/// and with `-sp fair`: under the other policies the shares come out
+/// equal whatever the weights.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_fair.hh"
+#include "system.hh"
+
+#include "semaphore.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+static const unsigned NUM_HOGS = 3;
+
+/// Weight of every hog, in units of the default one.
+static const unsigned WEIGHTS[NUM_HOGS] = {1, 2, 3};
+
+/// Ticks after the start at which the shares are printed; the last one
+/// ends the test.
+static const unsigned long CHECKPOINTS[] = {
+    2000, 10000, 50000, 200000
+};
+static const unsigned NUM_CHECKPOINTS
+  = sizeof CHECKPOINTS / sizeof CHECKPOINTS[0];
+
+static Thread *hogs[NUM_HOGS];
+static Semaphore *done;
+
+static unsigned long start;
+
+/// Next checkpoint to print.
+static unsigned checkpoint;
+
+/// Print the shares so far; return how far off the furthest one is, in
+/// percentage points.
+static double
+PrintShares(unsigned long ticks)
+{
+    unsigned long total = 0;
+    unsigned totalWeight = 0;
+    for (unsigned i = 0; i < NUM_HOGS; i++) {
+        total += hogs[i]->sched.runTime;
+        totalWeight += WEIGHTS[i];
+    }
+
+    double maxError = 0;
+    printf("%8lu", ticks);
+    for (unsigned i = 0; i < NUM_HOGS; i++) {
+        double share = total > 0 ? 100.0 * hogs[i]->sched.runTime / total
+                                 : 0;
+        double due = 100.0 * WEIGHTS[i] / totalWeight;
+        double error = share > due ? share - due : due - share;
+        if (error > maxError) {
+            maxError = error;
+        }
+        printf("  %5.1f%% (%4.1f%%)", share, due);
+    }
+    printf("\n");
+    return maxError;
+}
+
+static void
+Hog(void *arg)
+{
+    for (;;) {
+        // Let simulated time go by.
+        interrupt->SetLevel(INT_OFF);
+        unsigned long ticks = stats->totalTicks - start;
+        if (checkpoint == NUM_CHECKPOINTS) {
+            break;
+        }
+        if (ticks >= CHECKPOINTS[checkpoint]) {
+            double maxError = PrintShares(ticks);
+            if (++checkpoint == NUM_CHECKPOINTS) {
+                printf("Shares are off by %.1f points at most.\n",
+                       maxError);
+                break;
+            }
+        }
+        interrupt->SetLevel(INT_ON);
+    }
+    interrupt->SetLevel(INT_ON);
+    done->V();
+}
+
+/// Threads own their names.
+static Thread *
+NewThread(const char *threadName)
+{
+    char *name = new char [strlen(threadName) + 1];
+    strcpy(name, threadName);
+    return new Thread(name);
+}
+
+void
+ThreadTestFair()
+{
+    if (timer == nullptr) {
+        printf("There is no time slicing; run with `-rs`.\n");
+        return;
+    }
+    if (scheduler->GetPolicy() != POLICY_FAIR) {
+        printf("Weights only count under `-sp fair`.\n");
+    }
+
+    done = new Semaphore("done", 0);
+    checkpoint = 0;
+
+    printf("%8s", "ticks");
+    for (unsigned i = 0; i < NUM_HOGS; i++) {
+        char name[16];
+        sprintf(name, "hog %u", i);
+        hogs[i] = NewThread(name);
+        scheduler->SetWeight(hogs[i], WEIGHTS[i] * DEFAULT_WEIGHT);
+        printf("  %-15s", name);
+    }
+    printf("\n");
+
+    start = stats->totalTicks;
+    for (unsigned i = 0; i < NUM_HOGS; i++) {
+        hogs[i]->Fork(Hog, nullptr);
+    }
+    for (unsigned i = 0; i < NUM_HOGS; i++) {
+        done->P();
+    }
+    delete done;
+}
@@ -0,0 +1,165 @@
+/// Priority inheritance down a chain of locks.
+///
+/// A low priority thread holds locks `a` and `c`.  A medium one holds `b`
+/// and waits for `a`, and a high one waits for `b`: the low one should run
+/// with the priority of the high one, two locks away.  Another thread waits
+/// for `c`.  When the low one releases `a`, it should keep the priority of
+/// the waiter of `c`, and drop to its own once it releases `c` too.
+///
+/// Then some threads of different priorities wait on a semaphore, and
+/// should be woken up from the highest priority down.
+///
+/// The main thread has the highest priority, and sleeps to let the others
+/// run up to where they block.  Run it with the priority policy.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_inheritance.hh"
+#include "system.hh"
+
+#include "lock.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Ticks the main thread sleeps for the others to get going.
+static const unsigned long SETTLE = 1000;
+
+static Lock *a, *b, *c;
+static Semaphore *wake;
+static Semaphore *done;
+
+/// Priorities the low thread had after releasing `a` and then `c`, and the
+/// one the medium thread had at the end.
+static int afterA, afterC, mediumEnd;
+
+static void
+Check(const char *what, int got, int expected)
+{
+    printf("%-32s %2d (expected %2d).  %s\n", what, got, expected,
+           got == expected ? "OK" : "WRONG");
+}
+
+static void
+Low(void *arg)
+{
+    a->Acquire();
+    c->Acquire();
+    wake->P();
+    a->Release();
+    afterA = currentThread->GetPriority();
+    c->Release();
+    afterC = currentThread->GetPriority();
+    done->V();
+}
+
+static void
+Medium(void *arg)
+{
+    b->Acquire();
+    a->Acquire();
+    a->Release();
+    b->Release();
+    mediumEnd = currentThread->GetPriority();
+    done->V();
+}
+
+/// Waits for the lock in `arg`.
+static void
+Waiter(void *arg)
+{
+    Lock *lock = (Lock *) arg;
+    lock->Acquire();
+    lock->Release();
+    done->V();
+}
+
+static Semaphore *gate;
+
+/// Names of the threads woken up by `gate`, in order.
+static char order[64];
+
+static void
+GateWaiter(void *arg)
+{
+    gate->P();
+    strcat(order, currentThread->GetName());
+    done->V();
+}
+
+/// Threads own their names.
+static Thread *
+NewThread(const char *threadName, int priority)
+{
+    char *name = new char [strlen(threadName) + 1];
+    strcpy(name, threadName);
+    return new Thread(name, false, priority);
+}
+
+void
+ThreadTestInheritance()
+{
+    if (scheduler->GetPolicy() != POLICY_PRIORITY) {
+        printf("Run it with the priority policy.\n");
+        return;
+    }
+
+    a = new Lock("a");
+    b = new Lock("b");
+    c = new Lock("c");
+    wake = new Semaphore("wake", 0);
+    done = new Semaphore("done", 0);
+
+    Thread *low = NewThread("low", 1);
+    Thread *medium = NewThread("medium", 5);
+    low->Fork(Low, nullptr);
+    currentThread->SleepFor(SETTLE);
+    medium->Fork(Medium, nullptr);
+    currentThread->SleepFor(SETTLE);
+    Check("Low, with medium waiting", low->GetPriority(), 5);
+
+    NewThread("high", 8)->Fork(Waiter, b);
+    currentThread->SleepFor(SETTLE);
+    Check("Medium, with high waiting", medium->GetPriority(), 8);
+    Check("Low, through medium", low->GetPriority(), 8);
+
+    NewThread("other", 3)->Fork(Waiter, c);
+    currentThread->SleepFor(SETTLE);
+    Check("Low, with other waiting too", low->GetPriority(), 8);
+
+    wake->V();
+    for (unsigned i = 0; i < 4; i++) {
+        done->P();
+    }
+    Check("Low, after releasing a", afterA, 3);
+    Check("Low, after releasing c", afterC, 1);
+    Check("Medium, at the end", mediumEnd, 5);
+
+    gate = new Semaphore("gate", 0);
+    static const int GATE_PRIORITIES[] = { 2, 7, 4, 9 };
+    const unsigned numGate = sizeof GATE_PRIORITIES / sizeof (int);
+    for (unsigned i = 0; i < numGate; i++) {
+        char name[2] = { (char) ('0' + GATE_PRIORITIES[i]), '\0' };
+        NewThread(name, GATE_PRIORITIES[i])->Fork(GateWaiter, nullptr);
+    }
+    currentThread->SleepFor(SETTLE);
+    for (unsigned i = 0; i < numGate; i++) {
+        // Let each one run before waking up the next.
+        gate->V();
+        currentThread->SleepFor(SETTLE);
+    }
+    for (unsigned i = 0; i < numGate; i++) {
+        done->P();
+    }
+    printf("Semaphore wake up order: %s (expected 9742).  %s\n", order,
+           strcmp(order, "9742") == 0 ? "OK" : "WRONG");
+
+    delete gate;
+    delete done;
+    delete wake;
+    delete c;
+    delete b;
+    delete a;
+}
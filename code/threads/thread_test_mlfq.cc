@@ -0,0 +1,122 @@
+/// Response time of an interactive thread among CPU bound ones.
+///
+/// An “interactive” thread waits for input from a device that interrupts
+/// every `TIMER_TICKS`, while some threads just burn CPU.  The test prints
+/// how long the input waits, on average, until the interactive thread gets
+/// to run.  Run it with `-rs` so that there is time slicing, once with the
+/// default policy and once with `-sp mlfq`: the multilevel feedback queue
+/// moves the CPU bound threads down, so the wait should be shorter.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_mlfq.hh"
+#include "system.hh"
+
+#include "semaphore.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+static const unsigned NUM_HOGS = 3;
+
+/// Inputs the interactive thread waits for.
+static const unsigned NUM_INPUTS = 200;
+
+static Semaphore *input;
+static Semaphore *done;
+
+/// Set while the interactive thread waits for input.
+static bool waiting;
+
+/// When the input the interactive thread waits for arrived.
+static unsigned long arrival;
+
+static bool finished;
+
+/// Interrupt handler of the input device.
+static void
+InputArrived(void *arg)
+{
+    if (waiting) {
+        waiting = false;
+        arrival = stats->totalTicks;
+        input->V();
+    }
+}
+
+static void
+Interactive(void *arg)
+{
+    unsigned long totalWait = 0, maxWait = 0;
+    for (unsigned i = 0; i < NUM_INPUTS; i++) {
+        IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+        waiting = true;
+        input->P();
+        unsigned long wait = stats->totalTicks - arrival;
+        interrupt->SetLevel(oldLevel);
+
+        totalWait += wait;
+        if (wait > maxWait) {
+            maxWait = wait;
+        }
+    }
+    finished = true;
+    printf("Input waited %lu ticks on average, %lu at most.\n",
+           totalWait / NUM_INPUTS, maxWait);
+    done->V();
+}
+
+static void
+Hog(void *arg)
+{
+    unsigned long spins = 0;
+    while (!finished) {
+        // Let simulated time go by.
+        interrupt->SetLevel(INT_OFF);
+        interrupt->SetLevel(INT_ON);
+        spins++;
+    }
+    printf("%s spun %lu times.\n", currentThread->GetName(), spins);
+    done->V();
+}
+
+/// Threads own their names.
+static Thread *
+NewThread(const char *threadName)
+{
+    char *name = new char [strlen(threadName) + 1];
+    strcpy(name, threadName);
+    return new Thread(name);
+}
+
+void
+ThreadTestMlfq()
+{
+    if (timer == nullptr) {
+        printf("There is no time slicing; run with `-rs`.\n");
+        return;
+    }
+
+    input = new Semaphore("input", 0);
+    done = new Semaphore("done", 0);
+    waiting = finished = false;
+
+    // The input device.  It is never deleted, as its next interrupt is
+    // always scheduled.
+    new Timer(InputArrived, nullptr, false);
+
+    for (unsigned i = 0; i < NUM_HOGS; i++) {
+        char name[16];
+        sprintf(name, "hog %u", i);
+        NewThread(name)->Fork(Hog, nullptr);
+    }
+    NewThread("interactive")->Fork(Interactive, nullptr);
+
+    for (unsigned i = 0; i < NUM_HOGS + 1; i++) {
+        done->P();
+    }
+    delete input;
+    delete done;
+}
@@ -0,0 +1,201 @@
+/// Reader-writer locks and barriers.
+///
+/// First, a reader holds a reader-writer lock while a writer and then
+/// another reader come for it: the second reader should get in after the
+/// writer, not overtake it.  Then some readers and writers take the lock
+/// over and over, sleeping while they hold it; readers should get to hold
+/// it together, and writers only alone.  Last, some threads go through a
+/// barrier for a few rounds: none should leave a round before all of them
+/// arrive, and one of them should be told it came last.
+///
+/// The barrier threads count their arrivals under a lock, held while they
+/// sleep, so that running it with `-lp` shows some contention.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_rwlock.hh"
+#include "system.hh"
+
+#include "barrier.hh"
+#include "lock.hh"
+#include "rw_lock.hh"
+#include "semaphore.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Ticks the threads of the first part come apart.
+static const unsigned long STEP = 1000;
+
+static const unsigned NUM_READERS = 4;
+static const unsigned NUM_WRITERS = 2;
+static const unsigned NUM_TURNS = 5;
+
+static const unsigned NUM_PARTIES = 4;
+static const unsigned NUM_ROUNDS = 5;
+
+static RWLock *rw;
+static Semaphore *done;
+
+/// Who got the lock in the first part, in order.
+static char order[8];
+
+/// Threads holding `rw` in the second part, and the most readers seen
+/// holding it at once.
+static unsigned reading, writing, mostReading;
+static unsigned violations;
+
+static Lock *tally;
+static Barrier *barrier;
+static unsigned arrived[NUM_ROUNDS];
+static unsigned lastOnes;
+
+static void
+Check(const char *what, bool ok)
+{
+    printf("%-40s %s\n", what, ok ? "OK" : "WRONG");
+}
+
+static void
+OrderReader(void *arg)
+{
+    rw->AcquireRead();
+    strcat(order, (const char *) arg);
+    currentThread->SleepFor(3 * STEP);
+    rw->ReleaseRead();
+    done->V();
+}
+
+static void
+OrderWriter(void *arg)
+{
+    rw->AcquireWrite();
+    strcat(order, "W");
+    currentThread->SleepFor(STEP);
+    rw->ReleaseWrite();
+    done->V();
+}
+
+static void
+Reader(void *arg)
+{
+    unsigned n = *(const unsigned *) arg;
+    for (unsigned i = 0; i < NUM_TURNS; i++) {
+        rw->AcquireRead();
+        if (writing > 0) {
+            violations++;
+        }
+        if (++reading > mostReading) {
+            mostReading = reading;
+        }
+        currentThread->SleepFor(100 * (n + 1));
+        reading--;
+        rw->ReleaseRead();
+        currentThread->SleepFor(50 * (n + 1));
+    }
+    done->V();
+}
+
+static void
+Writer(void *arg)
+{
+    unsigned n = *(const unsigned *) arg;
+    for (unsigned i = 0; i < NUM_TURNS; i++) {
+        rw->AcquireWrite();
+        if (reading > 0 || writing > 0) {
+            violations++;
+        }
+        writing++;
+        currentThread->SleepFor(150);
+        writing--;
+        rw->ReleaseWrite();
+        currentThread->SleepFor(200 * (n + 1));
+    }
+    done->V();
+}
+
+static void
+Party(void *arg)
+{
+    unsigned n = *(const unsigned *) arg;
+    for (unsigned round = 0; round < NUM_ROUNDS; round++) {
+        currentThread->SleepFor(100 * (n + 1));
+        tally->Acquire();
+        arrived[round]++;
+        currentThread->SleepFor(100);
+        tally->Release();
+        if (barrier->Wait()) {
+            lastOnes++;
+        }
+        if (arrived[round] != NUM_PARTIES) {
+            violations++;
+        }
+    }
+    done->V();
+}
+
+/// Threads own their names.
+static Thread *
+NewThread(const char *threadName)
+{
+    char *name = new char [strlen(threadName) + 1];
+    strcpy(name, threadName);
+    return new Thread(name);
+}
+
+void
+ThreadTestRWLock()
+{
+    static const unsigned IDS[] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+    rw = new RWLock("rw");
+    done = new Semaphore("done", 0);
+
+    NewThread("first reader")->Fork(OrderReader, (void *) "R");
+    currentThread->SleepFor(STEP);
+    NewThread("writer")->Fork(OrderWriter, nullptr);
+    currentThread->SleepFor(STEP);
+    NewThread("second reader")->Fork(OrderReader, (void *) "r");
+    for (unsigned i = 0; i < 3; i++) {
+        done->P();
+    }
+    printf("Order: %s (expected RWr).  %s\n", order,
+           strcmp(order, "RWr") == 0 ? "OK" : "WRONG");
+
+    for (unsigned i = 0; i < NUM_READERS; i++) {
+        char name[16];
+        snprintf(name, sizeof name, "reader %u", i);
+        NewThread(name)->Fork(Reader, (void *) &IDS[i]);
+    }
+    for (unsigned i = 0; i < NUM_WRITERS; i++) {
+        char name[16];
+        snprintf(name, sizeof name, "writer %u", i);
+        NewThread(name)->Fork(Writer, (void *) &IDS[i]);
+    }
+    for (unsigned i = 0; i < NUM_READERS + NUM_WRITERS; i++) {
+        done->P();
+    }
+    printf("Most readers at once: %u.\n", mostReading);
+    Check("Readers hold the lock together", mostReading > 1);
+    Check("Writers hold the lock alone", violations == 0);
+
+    tally = new Lock("tally");
+    barrier = new Barrier("barrier", NUM_PARTIES);
+    for (unsigned i = 0; i < NUM_PARTIES; i++) {
+        char name[16];
+        snprintf(name, sizeof name, "party %u", i);
+        NewThread(name)->Fork(Party, (void *) &IDS[i]);
+    }
+    for (unsigned i = 0; i < NUM_PARTIES; i++) {
+        done->P();
+    }
+    Check("Nobody leaves a round early", violations == 0);
+    Check("One thread arrives last per round", lastOnes == NUM_ROUNDS);
+
+    delete barrier;
+    delete tally;
+    delete done;
+    delete rw;
+}
@@ -0,0 +1,161 @@
+/// Sleeping threads and timed waits.
+///
+/// Some threads sleep for times that fall in different levels of the timer
+/// wheel, and print how long they actually slept.  Others wait on a
+/// semaphore or a condition with a timeout, once with nobody to wake them
+/// up and once with a thread that does before the time is up.  Every
+/// thread should wake up no earlier than asked, and no more than a tick of
+/// the wheel later, plus the time it takes to run again.  Nobody is ready
+/// to run most of the time, so the machine idles meanwhile, and should not
+/// halt.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_timers.hh"
+#include "system.hh"
+
+#include "condition.hh"
+#include "semaphore.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+/// Ticks to sleep for; from a slot of the first level of the wheel to one
+/// of the third.
+static const unsigned long SLEEPS[] = { 3000, 500, 12000, 1000000, 40 };
+static const unsigned NUM_SLEEPS = sizeof SLEEPS / sizeof SLEEPS[0];
+
+/// Timeout of the timed waits, and when they are woken up if they are.
+static const unsigned long TIMEOUT = 5000;
+static const unsigned long WAKE_UP = 1000;
+
+/// Ticks a thread may take to run again once its timer expires: under
+/// `-rs`, the thread running then may finish a time slice of up to twice
+/// `TIMER_TICKS` first, and a timed wait on a condition has to acquire the
+/// lock again.
+static const unsigned long LATENCY = 2 * TIMER_TICKS + 5 * SYSTEM_TICK;
+
+static Semaphore *done;
+
+static Semaphore *resource;
+static Lock *lock;
+static Condition *condition;
+
+/// Check that `elapsed` ticks are no fewer than `asked`, and not too many
+/// more.
+static void
+Report(const char *what, unsigned long asked, unsigned long elapsed)
+{
+    bool ok = elapsed >= asked
+              && elapsed <= asked + TIMER_WHEEL_RESOLUTION + LATENCY;
+    printf("%s: asked for %lu ticks, took %lu.  %s\n",
+           what, asked, elapsed, ok ? "OK" : "WRONG");
+}
+
+static void
+Sleeper(void *arg)
+{
+    unsigned long ticks = *(const unsigned long *) arg;
+    unsigned long start = stats->totalTicks;
+    currentThread->SleepFor(ticks);
+    Report(currentThread->GetName(), ticks, stats->totalTicks - start);
+    done->V();
+}
+
+/// A wait that is woken up should return as soon as it is, long before
+/// its timeout.
+static void
+ReportWait(const char *what, bool wokenUp, bool succeeded,
+           unsigned long elapsed)
+{
+    if (!wokenUp) {
+        ASSERT(!succeeded);
+        Report(what, TIMEOUT, elapsed);
+    } else {
+        ASSERT(succeeded);
+        printf("%s: woken up after %lu ticks.  %s\n", what, elapsed,
+               elapsed < TIMEOUT ? "OK" : "WRONG");
+    }
+}
+
+/// Wait on the semaphore and on the condition; both time out if `arg` is
+/// null, and are woken up after about `WAKE_UP` ticks otherwise.
+static void
+Waiter(void *arg)
+{
+    bool wokenUp = arg != nullptr;
+
+    unsigned long start = stats->totalTicks;
+    bool acquired = resource->P(TIMEOUT);
+    ReportWait("P", wokenUp, acquired, stats->totalTicks - start);
+
+    lock->Acquire();
+    start = stats->totalTicks;
+    bool signalled = condition->Wait(TIMEOUT);
+    ReportWait("Wait", wokenUp, signalled, stats->totalTicks - start);
+    ASSERT(lock->IsHeldByCurrentThread());
+    lock->Release();
+
+    done->V();
+}
+
+/// Wake the second waiter up, once for each of its waits.
+static void
+Waker(void *arg)
+{
+    currentThread->SleepFor(WAKE_UP);
+    resource->V();
+
+    // The waiter gets to the condition while this one sleeps.
+    currentThread->SleepFor(WAKE_UP);
+    lock->Acquire();
+    condition->Signal();
+    lock->Release();
+
+    done->V();
+}
+
+/// Threads own their names.
+static Thread *
+NewThread(const char *threadName)
+{
+    char *name = new char [strlen(threadName) + 1];
+    strcpy(name, threadName);
+    return new Thread(name);
+}
+
+void
+ThreadTestTimers()
+{
+    done = new Semaphore("done", 0);
+    resource = new Semaphore("resource", 0);
+    lock = new Lock("timed");
+    condition = new Condition("timed", lock);
+
+    for (unsigned i = 0; i < NUM_SLEEPS; i++) {
+        char name[32];
+        sprintf(name, "sleeper %lu", SLEEPS[i]);
+        NewThread(name)->Fork(Sleeper, (void *) &SLEEPS[i]);
+    }
+    NewThread("waiter")->Fork(Waiter, nullptr);
+    for (unsigned i = 0; i < NUM_SLEEPS + 1; i++) {
+        done->P();
+    }
+
+    // The second waiter only starts once the first is done, so that the
+    // wake ups go to it.
+    NewThread("woken waiter")->Fork(Waiter, (void *) 1);
+    NewThread("waker")->Fork(Waker, nullptr);
+    for (unsigned i = 0; i < 2; i++) {
+        done->P();
+    }
+
+    printf("Timers still pending: %u.\n", timerWheel->GetPending());
+
+    delete condition;
+    delete lock;
+    delete resource;
+    delete done;
+}
@@ -0,0 +1,181 @@
+/// Routines to manage the timers of the kernel.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "timer_wheel.hh"
+#include "system.hh"
+
+static const unsigned long SLOT_MASK = TIMER_WHEEL_SLOTS - 1;
+
+/// Ticks of the wheel covered by all of its levels.
+static const unsigned long WHEEL_SPAN
+  = 1UL << TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS;
+
+TimerEntry::TimerEntry()
+{
+    handler = nullptr;
+    arg = nullptr;
+    expires = 0;
+    level = slot = 0;
+}
+
+bool
+TimerEntry::IsPending() const
+{
+    return link.IsLinked();
+}
+
+/// Dummy function because C++ does not allow pointers to member functions.
+static void
+WheelTick(void *arg)
+{
+    ASSERT(arg != nullptr);
+    ((TimerWheel *) arg)->Tick();
+}
+
+TimerWheel::TimerWheel()
+{
+    now = 0;
+    nextTickAt = 0;
+    armed = false;
+    pending = 0;
+}
+
+TimerWheel::~TimerWheel()
+{}
+
+void
+TimerWheel::Start(TimerEntry *entry, unsigned long ticks,
+                  VoidFunctionPtr handler, void *arg)
+{
+    ASSERT(entry != nullptr);
+    ASSERT(!entry->IsPending());
+    ASSERT(handler != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (!armed)
+    {
+        Arm();
+    }
+
+    // The next tick of the wheel is less than a resolution away; count
+    // the ticks needed after that one.
+    unsigned long untilNext = nextTickAt > stats->totalTicks
+                              ? nextTickAt - stats->totalTicks : 0;
+    if (untilNext > TIMER_WHEEL_RESOLUTION)
+    {
+        untilNext = TIMER_WHEEL_RESOLUTION;  // Ticks were restarted.
+    }
+    unsigned long after = ticks > untilNext
+      ? DivRoundUp(ticks - untilNext, TIMER_WHEEL_RESOLUTION) : 0;
+
+    entry->handler = handler;
+    entry->arg = arg;
+    entry->expires = now + 1 + after;
+    Place(entry);
+    pending++;
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+TimerWheel::Cancel(TimerEntry *entry)
+{
+    ASSERT(entry != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (entry->IsPending())
+    {
+        slots[entry->level][entry->slot].Remove(entry);
+        pending--;
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+unsigned
+TimerWheel::GetPending() const
+{
+    return pending;
+}
+
+/// A timer goes to the lowest level whose turn reaches its expiration
+/// time.  Those beyond the last level go as far as it reaches, and are
+/// placed again when their slot comes.
+void
+TimerWheel::Place(TimerEntry *entry)
+{
+    ASSERT(entry->expires >= now);
+
+    unsigned long delta = entry->expires - now;
+    unsigned long when = entry->expires;
+    if (delta >= WHEEL_SPAN)
+    {
+        when = now + WHEEL_SPAN - 1;
+        delta = WHEEL_SPAN - 1;
+    }
+
+    unsigned level = 0;
+    while (delta >= 1UL << TIMER_WHEEL_BITS * (level + 1))
+    {
+        level++;
+    }
+    entry->level = level;
+    entry->slot = (when >> TIMER_WHEEL_BITS * level) & SLOT_MASK;
+    slots[level][entry->slot].Append(entry);
+}
+
+void
+TimerWheel::Cascade(unsigned level, unsigned slot)
+{
+    TimerEntry *entry;
+    while ((entry = slots[level][slot].Pop()) != nullptr)
+    {
+        Place(entry);
+    }
+}
+
+void
+TimerWheel::Arm()
+{
+    ASSERT(!armed);
+
+    armed = true;
+    nextTickAt = stats->totalTicks + TIMER_WHEEL_RESOLUTION;
+    interrupt->Schedule(WheelTick, this, TIMER_WHEEL_RESOLUTION, ALARM_INT);
+}
+
+/// Move the wheel on by one tick, and run the handlers of the timers that
+/// expire at it.  Called with interrupts disabled.
+void
+TimerWheel::Tick()
+{
+    armed = false;
+    now++;
+
+    // Cascade every level that comes to a new slot, lowest first.
+    unsigned long turn = now;
+    for (unsigned level = 1;
+         level < TIMER_WHEEL_LEVELS && (turn & SLOT_MASK) == 0; level++)
+    {
+        turn >>= TIMER_WHEEL_BITS;
+        Cascade(level, turn & SLOT_MASK);
+    }
+
+    TimerList &due = slots[0][now & SLOT_MASK];
+    TimerEntry *entry;
+    while ((entry = due.Pop()) != nullptr)
+    {
+        pending--;
+        entry->handler(entry->arg);
+    }
+
+    if (pending > 0 && !armed)
+    {
+        Arm();
+    }
+}
@@ -0,0 +1,118 @@
+/// Timers for the kernel, kept in a hierarchical timer wheel.
+///
+/// The wheel has `TIMER_WHEEL_LEVELS` levels of `TIMER_WHEEL_SLOTS` slots
+/// each.  A slot of the first level holds the timers that expire in one
+/// tick of the wheel (`TIMER_WHEEL_RESOLUTION` ticks of simulated time); a
+/// slot of every other level spans a whole turn of the level below.  When
+/// a level turns around, the timers in the next slot of the level above are
+/// spread over the level below (“cascade”).  Starting, cancelling and
+/// expiring a timer take constant time, and every timer is moved at most
+/// once per level.
+///
+/// The wheel moves on with an interrupt of the timer device of its own,
+/// which is only pending while some timer is.  This also keeps the machine
+/// from halting when every thread is sleeping on a timer.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_TIMERWHEEL__HH
+#define NACHOS_THREADS_TIMERWHEEL__HH
+
+#include "lib/intrusive_list.hh"
+#include "lib/utility.hh"
+
+/// Ticks of simulated time per tick of the wheel.
+const unsigned long TIMER_WHEEL_RESOLUTION = 100;
+
+/// Slots per level, as a power of two.
+const unsigned TIMER_WHEEL_BITS = 6;
+const unsigned TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_BITS;
+
+/// Timers further away than `TIMER_WHEEL_SLOTS` to the power of this wait
+/// in the last level until they get closer.
+const unsigned TIMER_WHEEL_LEVELS = 4;
+
+class TimerWheel;
+
+/// A timer, to be embedded in whatever is waiting for it.
+class TimerEntry
+{
+public:
+    TimerEntry();
+
+    /// Is the timer started and not expired or cancelled yet?
+    bool IsPending() const;
+
+    /// Link for the slot the timer is in.
+    ListLink<TimerEntry> link;
+
+private:
+    friend class TimerWheel;
+
+    VoidFunctionPtr handler;
+    void *arg;
+
+    /// Tick of the wheel at which the timer expires.
+    unsigned long expires;
+
+    /// Slot the timer is in, while pending.
+    unsigned level;
+    unsigned slot;
+};
+
+typedef IntrusiveList<TimerEntry, &TimerEntry::link> TimerList;
+
+class TimerWheel
+{
+public:
+    TimerWheel();
+
+    /// The timers left are not expired.
+    ~TimerWheel();
+
+    /// Call `handler(arg)` with interrupts disabled once `ticks` ticks of
+    /// simulated time have gone by, or a little later.
+    ///
+    /// `entry` must not be pending already, and it must stay where it is
+    /// until it expires or is cancelled.
+    void Start(TimerEntry *entry, unsigned long ticks,
+               VoidFunctionPtr handler, void *arg);
+
+    /// Stop `entry` from expiring, if it is still pending.
+    void Cancel(TimerEntry *entry);
+
+    /// Number of timers pending.
+    unsigned GetPending() const;
+
+    /// Internal routine of the wheel -- called from the interrupt of the
+    /// timer device.
+    void Tick();
+
+private:
+    /// Put `entry` in the slot for its expiration time.
+    void Place(TimerEntry *entry);
+
+    /// Spread the timers of `slot` of `level` over the levels below.
+    void Cascade(unsigned level, unsigned slot);
+
+    /// Make the timer device interrupt at the next tick of the wheel.
+    void Arm();
+
+    TimerList slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+
+    /// Ticks of the wheel so far.
+    unsigned long now;
+
+    /// Simulated time at which the next tick of the wheel happens; only
+    /// meaningful while `armed`.
+    unsigned long nextTickAt;
+
+    /// Whether an interrupt for the next tick is pending.
+    bool armed;
+
+    unsigned pending;
+};
+
+#endif
@@ -0,0 +1,24 @@
+/// Child of the memory-mapped files test; see `mmap_test.c`.
+///
+/// The file is neither unmapped nor closed: exiting must write it back.
+
+#include "syscall.h"
+
+
+#define FILE_NAME  "mmap_test.txt"
+#define FILE_SIZE  300
+
+int
+main(void)
+{
+    OpenFileId file = Open(FILE_NAME);
+    char *mapped = Mmap(file, FILE_SIZE);
+    if (mapped == 0) {
+        Write("Cannot map the file.\n", 21, CONSOLE_OUTPUT);
+        Exit(1);
+    }
+    for (int i = 0; i < FILE_SIZE; i++) {
+        mapped[i] = 'c';
+    }
+    return 0;
+}
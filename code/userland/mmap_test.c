@@ -0,0 +1,78 @@
+/// Test of memory-mapped files.
+///
+/// Create a file, map it and fill it through memory: once unmapped, the
+/// file must hold what was stored.  Then run `mmap_child`, which maps the
+/// same file, fills it with something else and exits without unmapping it:
+/// once it is joined, the file must hold that too.
+
+#include "syscall.h"
+
+
+#define FILE_NAME  "mmap_test.txt"
+
+/// Longer than a page, so that the mapping takes more than one.
+#define FILE_SIZE  300
+
+static unsigned
+Length(const char *s)
+{
+    unsigned i;
+    for (i = 0; s[i] != '\0'; i++) {
+    }
+    return i;
+}
+
+static void
+Print(const char *s)
+{
+    Write(s, Length(s), CONSOLE_OUTPUT);
+}
+
+/// Check that every byte of the file is `expected`.
+static int
+Check(const char *what, char expected)
+{
+    char buffer[FILE_SIZE];
+    OpenFileId file = Open(FILE_NAME);
+    int read = Read(buffer, FILE_SIZE, file);
+    Close(file);
+
+    int ok = read == FILE_SIZE;
+    for (int i = 0; ok && i < FILE_SIZE; i++) {
+        ok = buffer[i] == expected;
+    }
+    Print(what);
+    Print(ok ? ": OK\n" : ": WRONG\n");
+    return ok;
+}
+
+int
+main(void)
+{
+    char buffer[FILE_SIZE];
+    for (int i = 0; i < FILE_SIZE; i++) {
+        buffer[i] = '.';
+    }
+    Create(FILE_NAME);
+    OpenFileId file = Open(FILE_NAME);
+    Write(buffer, FILE_SIZE, file);
+
+    char *mapped = Mmap(file, FILE_SIZE);
+    if (mapped == 0) {
+        Print("Cannot map the file.\n");
+        Exit(1);
+    }
+    for (int i = 0; i < FILE_SIZE; i++) {
+        mapped[i] = 'p';
+    }
+    Munmap(mapped);
+    Close(file);
+    int ok = Check("Written back by Munmap", 'p');
+
+    SpaceId child = Exec("../userland/mmap_child", 0, 1);
+    Join(child);
+    ok = Check("Written back on exit", 'c') && ok;
+
+    Remove(FILE_NAME);
+    return ok ? 0 : 1;
+}
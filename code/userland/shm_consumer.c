@@ -0,0 +1,27 @@
+/// Consumer side of the shared-memory test; see `shm_producer.c`.
+
+#include "syscall.h"
+
+
+int
+main(void)
+{
+    char *buffer = ShmAttach("shmtest");
+    if (buffer == 0) {
+        Write("Cannot attach segment.\n", 23, CONSOLE_OUTPUT);
+        Exit(1);
+    }
+
+    if (buffer[0] == 0) {
+        Write("Segment is empty.\n", 18, CONSOLE_OUTPUT);
+        Exit(1);
+    }
+
+    int length;
+    for (length = 0; buffer[length + 1] != '\0'; length++) {
+    }
+    Write(&buffer[1], length, CONSOLE_OUTPUT);
+
+    ShmDetach(buffer);
+    return 0;
+}
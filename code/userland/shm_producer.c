@@ -0,0 +1,35 @@
+/// Producer side of the shared-memory test.
+///
+/// Create a segment, fill it with a message and run `shm_consumer`, which
+/// attaches the same segment and prints what it finds there.  The message
+/// never goes through a file or the console buffers.
+
+#include "syscall.h"
+
+
+#define SEGMENT_SIZE  1024
+
+int
+main(void)
+{
+    char *buffer = ShmCreate("shmtest", SEGMENT_SIZE);
+    if (buffer == 0) {
+        Write("Cannot create segment.\n", 23, CONSOLE_OUTPUT);
+        Exit(1);
+    }
+
+    const char *message = "Hello through shared memory!\n";
+    int i;
+    for (i = 0; message[i] != '\0'; i++) {
+        buffer[i + 1] = message[i];
+    }
+    buffer[i + 1] = '\0';
+    // The first byte tells the consumer that there is a message.
+    buffer[0] = 1;
+
+    SpaceId consumer = Exec("../userland/shm_consumer", 0, 1);
+    int status = Join(consumer);
+
+    ShmDetach(buffer);
+    return status;
+}
@@ -1,10 +1,14 @@
 #include "lib.c"
 
+/// Ticks of simulated time between dots.
+#define SLEEP_TICKS 10000
+
 int main()
 {
 
   while (1)
   {
     puts_lib(".");
+    Sleep(SLEEP_TICKS);
   }
-}
\ No newline at end of file
+}
@@ -141,6 +141,54 @@ Ps:
         j       $31
         .end    Ps
 
+        .globl  Mmap
+        .ent    Mmap
+Mmap:
+        addiu   $2, $0, SC_MMAP
+        syscall
+        j       $31
+        .end    Mmap
+
+        .globl  Munmap
+        .ent    Munmap
+Munmap:
+        addiu   $2, $0, SC_MUNMAP
+        syscall
+        j       $31
+        .end    Munmap
+
+        .globl  ShmCreate
+        .ent    ShmCreate
+ShmCreate:
+        addiu   $2, $0, SC_SHM_CREATE
+        syscall
+        j       $31
+        .end    ShmCreate
+
+        .globl  ShmAttach
+        .ent    ShmAttach
+ShmAttach:
+        addiu   $2, $0, SC_SHM_ATTACH
+        syscall
+        j       $31
+        .end    ShmAttach
+
+        .globl  ShmDetach
+        .ent    ShmDetach
+ShmDetach:
+        addiu   $2, $0, SC_SHM_DETACH
+        syscall
+        j       $31
+        .end    ShmDetach
+
+        .globl  Sleep
+        .ent    Sleep
+Sleep:
+        addiu   $2, $0, SC_SLEEP
+        syscall
+        j       $31
+        .end    Sleep
+
 /// Dummy function to keep gcc happy.
         .globl  __main
         .ent    __main
@@ -10,8 +10,19 @@
 #include "threads/system.hh"
 #include "lib/utility.hh"
 
+#include <stdio.h>
 #include <string.h>
 
+#ifdef USE_TLB
+/// Next TLB slot to be replaced, in round-robin order.
+static unsigned nextTlbEntry = 0;
+#endif
+
+/// Used to give every address space a different identifier.
+static unsigned nextAsid = 0;
+
+AddressSpace *AddressSpace::loaded = nullptr;
+
 /// First, set up the translation from program memory to physical memory.
 /// For now, this is really simple (1:1), since we are only uniprogramming,
 /// and we have a single unsegmented page table.
@@ -29,13 +40,64 @@ AddressSpace::AddressSpace(OpenFile* executable_file)
     numPages = DivRoundUp(size, PAGE_SIZE);
     size = numPages * PAGE_SIZE;
 
-    ASSERT(numPages <= pageMap->CountClear());
+#ifndef VMEM
+    ASSERT(numPages <= coreMap->CountClear());
     // Check we are not trying to run anything too big -- at least until we
     // have virtual memory.
+#endif
 
     DEBUG('a', "Initializing address space, num pages %u, size %u\n",
         numPages, size);
 
+    asid = nextAsid++;
+    mappedFiles = new Table<MappedFile *>();
+    sharedMappings = new Table<SharedMapping *>();
+
+#ifdef VMEM
+    // Pages are brought in from the swap file on demand, so the whole
+    // initial image of the program is written there.
+    swapPages = numPages;
+    snprintf(swapName, sizeof swapName, "SWAP.%u", asid);
+    ASSERT(fileSystem->Create(swapName, size));
+    swapFile = fileSystem->Open(swapName);
+    ASSERT(swapFile != nullptr);
+
+    uint32_t codeAddr = exe.GetCodeAddr();
+    uint32_t codeSize = exe.GetCodeSize();
+    uint32_t initDataSize = exe.GetInitDataSize();
+
+    char *image = new char[size];
+    memset(image, 0, size);
+    if (codeSize > 0)
+    {
+        exe.ReadCodeBlock(&image[codeAddr], codeSize, 0);
+    }
+    if (initDataSize > 0)
+    {
+        exe.ReadDataBlock(&image[exe.GetInitDataAddr()], initDataSize, 0);
+    }
+    swapFile->WriteAt(image, size, 0);
+    delete[] image;
+
+    pageTable = new TranslationEntry[numPages];
+    for (unsigned i = 0; i < numPages; i++)
+    {
+        pageTable[i].virtualPage = i;
+        pageTable[i].physicalPage = 0;
+        pageTable[i].valid = false;
+        pageTable[i].use = false;
+        pageTable[i].dirty = false;
+        // Pages that hold nothing but code are read-only.
+        pageTable[i].readOnly = i * PAGE_SIZE >= codeAddr
+                                && (i + 1) * PAGE_SIZE <= codeAddr + codeSize;
+    }
+    workingSet = new WorkingSet(numPages);
+    prefetched = new bool[swapPages];
+    for (unsigned i = 0; i < swapPages; i++)
+    {
+        prefetched[i] = false;
+    }
+#else
     // First, set up the translation.
 
     char* mainMemory = machine->GetMMU()->mainMemory;
@@ -45,7 +107,7 @@ AddressSpace::AddressSpace(OpenFile* executable_file)
     {
         pageTable[i].virtualPage = i;
         // For now, virtual page number = physical page number.
-        pageTable[i].physicalPage = pageMap->Find();
+        pageTable[i].physicalPage = AllocateFrame(i);
         pageTable[i].valid = true;
         pageTable[i].use = false;
         pageTable[i].dirty = false;
@@ -128,6 +190,13 @@ AddressSpace::AddressSpace(OpenFile* executable_file)
             virtualAddr += toRead;
         };
     }
+#endif
+
+    // The new program may hold pages identical to those of others.
+    if (pageDeduplicator != nullptr)
+    {
+        pageDeduplicator->Wake();
+    }
 }
 
 uint32_t
@@ -147,23 +216,787 @@ AddressSpace::TranslateVirtualAddrToPhysicalAddr(uint32_t virtualAddr, uint32_t*
 
 /// Deallocate an address space.
 ///
-/// Nothing for now!
+/// Mapped regions are written back first, so that the files they refer to
+/// must still be open.
 AddressSpace::~AddressSpace()
 {
+    UnmapAll();
+    delete mappedFiles;
+
+    for (unsigned i = 0; i < sharedMappings->GetCapacity(); i++)
+    {
+        if (sharedMappings->HasKey(i))
+        {
+            SharedMapping *mapping = sharedMappings->Remove(i);
+            ReleaseSegment(mapping);
+            delete mapping;
+        }
+    }
+    delete sharedMappings;
+
     for (unsigned i = 0; i < numPages; i++)
     {
-        pageMap->Clear(pageTable[i].physicalPage);
+        if (pageTable[i].valid)
+        {
+            coreMap->Release(pageTable[i].physicalPage, this, i);
+        }
     }
 
     delete[] pageTable;
+
+    if (loaded == this)
+    {
+        // Nothing must translate through it any more.
+#ifdef USE_TLB
+        TranslationEntry *tlb = machine->GetMMU()->tlb;
+        for (unsigned i = 0; i < TLB_SIZE; i++)
+        {
+            tlb[i].valid = false;
+        }
+#else
+        machine->GetMMU()->pageTable = nullptr;
+        machine->GetMMU()->pageTableSize = 0;
+#endif
+        loaded = nullptr;
+    }
+
+#ifdef VMEM
+    if (compressedCache != nullptr)
+    {
+        compressedCache->Discard(this);
+    }
+    delete swapFile;
+    fileSystem->Remove(swapName);
+    delete workingSet;
+    for (unsigned i = 0; i < swapPages; i++)
+    {
+        if (prefetched[i])
+        {
+            stats->numPrefetchWasted++;
+        }
+    }
+    delete[] prefetched;
+#endif
+}
+
+unsigned
+AddressSpace::MapFile(OpenFile *file, int fileId, unsigned length)
+{
+    ASSERT(file != nullptr);
+    ASSERT(length > 0);
+
+    if (length > file->Length())
+    {
+        DEBUG('a', "Cannot map %u bytes of a file of %u.\n",
+              length, file->Length());
+        return 0;
+    }
+    if (!CanGrow(DivRoundUp(length, PAGE_SIZE)))
+    {
+        DEBUG('a', "No room to map %u bytes.\n", length);
+        return 0;
+    }
+
+    MappedFile *mapping = new MappedFile;
+    mapping->file = file;
+    mapping->fileId = fileId;
+    mapping->numPages = DivRoundUp(length, PAGE_SIZE);
+    mapping->length = length;
+
+    if (mappedFiles->Add(mapping) == -1)
+    {
+        DEBUG('a', "Too many mapped regions.\n");
+        delete mapping;
+        return 0;
+    }
+
+    // The new pages are only brought in on demand.
+    mapping->firstPage = GrowPageTable(mapping->numPages);
+
+    DEBUG('a', "Mapped %u bytes of file %d at virtual page %u.\n",
+          length, fileId, mapping->firstPage);
+    return mapping->firstPage * PAGE_SIZE;
+}
+
+bool
+AddressSpace::UnmapFile(unsigned virtualAddr)
+{
+    if (virtualAddr % PAGE_SIZE != 0)
+    {
+        return false;
+    }
+
+    unsigned vpn = virtualAddr / PAGE_SIZE;
+    for (unsigned i = 0; i < mappedFiles->GetCapacity(); i++)
+    {
+        if (mappedFiles->HasKey(i) && mappedFiles->Get(i)->firstPage == vpn)
+        {
+#ifdef USE_TLB
+            SyncTlb();
+            // Stale translations must not survive the unmapping.
+            RestoreState();
+#endif
+            MappedFile *mapping = mappedFiles->Remove(i);
+            WriteBackMapping(mapping);
+            delete mapping;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// The space may still be in the MMU, with dirty bits only in the TLB.
+void
+AddressSpace::UnmapAll()
+{
+#ifdef USE_TLB
+    if (loaded == this)
+    {
+        SyncTlb();
+    }
+#endif
+
+    for (unsigned i = 0; i < mappedFiles->GetCapacity(); i++)
+    {
+        if (mappedFiles->HasKey(i))
+        {
+            MappedFile *mapping = mappedFiles->Remove(i);
+            WriteBackMapping(mapping);
+            delete mapping;
+        }
+    }
+
+#ifdef USE_TLB
+    if (loaded == this)
+    {
+        // Stale translations must not survive the unmapping.
+        RestoreState();
+    }
+#endif
+}
+
+bool
+AddressSpace::IsMapped(int fileId) const
+{
+    for (unsigned i = 0; i < mappedFiles->GetCapacity(); i++)
+    {
+        if (mappedFiles->HasKey(i) && mappedFiles->Get(i)->fileId == fileId)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+unsigned
+AddressSpace::AttachSegment(SharedSegment *segment)
+{
+    ASSERT(segment != nullptr);
+
+    if (!CanGrow(segment->GetNumPages()))
+    {
+        DEBUG('a', "No room to attach segment `%s`.\n", segment->GetName());
+        return 0;
+    }
+
+    SharedMapping *mapping = new SharedMapping;
+    mapping->segment = segment;
+
+    if (sharedMappings->Add(mapping) == -1)
+    {
+        DEBUG('a', "Too many attached segments.\n");
+        delete mapping;
+        return 0;
+    }
+
+    mapping->firstPage = GrowPageTable(segment->GetNumPages());
+    for (unsigned i = 0; i < segment->GetNumPages(); i++)
+    {
+        TranslationEntry *entry = &pageTable[mapping->firstPage + i];
+        entry->physicalPage = segment->GetFrame(i);
+        entry->valid = true;
+        coreMap->Share(entry->physicalPage, this, mapping->firstPage + i);
+    }
+
+    DEBUG('a', "Attached segment `%s` at virtual page %u.\n",
+          segment->GetName(), mapping->firstPage);
+    return mapping->firstPage * PAGE_SIZE;
+}
+
+bool
+AddressSpace::DetachSegment(unsigned virtualAddr)
+{
+    if (virtualAddr % PAGE_SIZE != 0)
+    {
+        return false;
+    }
+
+    unsigned vpn = virtualAddr / PAGE_SIZE;
+    for (unsigned i = 0; i < sharedMappings->GetCapacity(); i++)
+    {
+        if (sharedMappings->HasKey(i)
+            && sharedMappings->Get(i)->firstPage == vpn)
+        {
+            SharedMapping *mapping = sharedMappings->Remove(i);
+            ReleaseSegment(mapping);
+            delete mapping;
+#ifdef USE_TLB
+            RestoreState();
+#endif
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+AddressSpace::ReleaseSegment(SharedMapping *mapping)
+{
+    ASSERT(mapping != nullptr);
+
+    for (unsigned i = 0; i < mapping->segment->GetNumPages(); i++)
+    {
+        TranslationEntry *entry = &pageTable[mapping->firstPage + i];
+        coreMap->Release(entry->physicalPage, this, mapping->firstPage + i);
+        entry->valid = false;
+    }
+    DEBUG('a', "Detached segment `%s`.\n", mapping->segment->GetName());
+    sharedMemory->Detach(mapping->segment);
+}
+
+bool
+AddressSpace::CanGrow(unsigned count) const
+{
+    return numPages <= MAX_USER_PAGES && count <= MAX_USER_PAGES - numPages;
+}
+
+unsigned
+AddressSpace::GrowPageTable(unsigned count)
+{
+    unsigned firstPage = numPages;
+    unsigned newNumPages = numPages + count;
+    TranslationEntry *newPageTable = new TranslationEntry[newNumPages];
+    memcpy(newPageTable, pageTable, numPages * sizeof *pageTable);
+    for (unsigned i = numPages; i < newNumPages; i++)
+    {
+        newPageTable[i].virtualPage = i;
+        newPageTable[i].physicalPage = 0;
+        newPageTable[i].valid = false;
+        newPageTable[i].use = false;
+        newPageTable[i].dirty = false;
+        newPageTable[i].readOnly = false;
+    }
+    delete[] pageTable;
+    pageTable = newPageTable;
+    numPages = newNumPages;
+#ifdef VMEM
+    workingSet->Grow(numPages);
+#endif
+
+    if (IsLoaded())
+    {
+        RestoreState();
+    }
+    return firstPage;
+}
+
+bool
+AddressSpace::BreakCopyOnWrite(unsigned vpn)
+{
+    if (vpn >= numPages || !pageTable[vpn].valid)
+    {
+        return false;
+    }
+
+#ifdef USE_TLB
+    SyncTlb();
+#endif
+
+    TranslationEntry *entry = &pageTable[vpn];
+    unsigned frame = entry->physicalPage;
+    if (!coreMap->IsCopyOnWrite(frame))
+    {
+        return false;
+    }
+
+    if (coreMap->GetRefCount(frame) > 1)
+    {
+        int copy = AllocateFrame(vpn);
+        if (copy == -1)
+        {
+            DEBUG('a', "No free frame to copy page %u.\n", vpn);
+            return false;
+        }
+        char *mainMemory = machine->GetMMU()->mainMemory;
+        memcpy(&mainMemory[copy * PAGE_SIZE], &mainMemory[frame * PAGE_SIZE],
+               PAGE_SIZE);
+        coreMap->Release(frame, this, vpn);
+        entry->physicalPage = copy;
+        stats->numCowBreaks++;
+        DEBUG('a', "Copied page %u from frame %u to frame %d.\n",
+              vpn, frame, copy);
+    }
+    else
+    {
+        // Every other page mapping the frame got its own copy already.
+        coreMap->ClearCopyOnWrite(frame);
+    }
+    entry->readOnly = false;
+
+#ifdef USE_TLB
+    // Drop the stale translation; it is reloaded with the next fault.
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < TLB_SIZE; i++)
+    {
+        if (tlb[i].valid && tlb[i].virtualPage == vpn)
+        {
+            tlb[i].valid = false;
+        }
+    }
+#endif
+    return true;
+}
+
+unsigned
+AddressSpace::GetNumPages() const
+{
+    return numPages;
+}
+
+TranslationEntry *
+AddressSpace::GetPageEntry(unsigned vpn) const
+{
+    ASSERT(vpn < numPages);
+
+    return &pageTable[vpn];
+}
+
+MappedFile *
+AddressSpace::FindMapping(unsigned vpn) const
+{
+    for (unsigned i = 0; i < mappedFiles->GetCapacity(); i++)
+    {
+        if (!mappedFiles->HasKey(i))
+        {
+            continue;
+        }
+        MappedFile *mapping = mappedFiles->Get(i);
+        if (vpn >= mapping->firstPage
+            && vpn < mapping->firstPage + mapping->numPages)
+        {
+            return mapping;
+        }
+    }
+    return nullptr;
+}
+
+bool
+AddressSpace::LoadMappedPage(MappedFile *mapping, unsigned vpn)
+{
+    ASSERT(mapping != nullptr);
+
+    int frame = AllocateFrame(vpn);
+    if (frame == -1)
+    {
+        DEBUG('a', "No free frame for mapped page %u.\n", vpn);
+        return false;
+    }
+
+    coreMap->Pin(frame);
+    char *page = &machine->GetMMU()->mainMemory[frame * PAGE_SIZE];
+    unsigned offset = (vpn - mapping->firstPage) * PAGE_SIZE;
+    unsigned toRead = mapping->length - offset < PAGE_SIZE
+                      ? mapping->length - offset : PAGE_SIZE;
+
+    // Whatever lies beyond the end of the file reads as zeros.
+    memset(page, 0, PAGE_SIZE);
+    int read = mapping->file->ReadAt(page, toRead, offset);
+    DEBUG('a', "Loaded mapped page %u into frame %d (%d bytes).\n",
+          vpn, frame, read);
+    coreMap->Unpin(frame);
+
+    pageTable[vpn].physicalPage = frame;
+    pageTable[vpn].valid = true;
+    pageTable[vpn].use = false;
+    pageTable[vpn].dirty = false;
+    return true;
+}
+
+void
+AddressSpace::WriteBackPage(MappedFile *mapping, unsigned vpn)
+{
+    ASSERT(mapping != nullptr);
+
+    TranslationEntry *entry = &pageTable[vpn];
+    unsigned offset = (vpn - mapping->firstPage) * PAGE_SIZE;
+    unsigned toWrite = mapping->length - offset < PAGE_SIZE
+                       ? mapping->length - offset : PAGE_SIZE;
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    mapping->file->WriteAt(&mainMemory[entry->physicalPage * PAGE_SIZE],
+                           toWrite, offset);
+    DEBUG('a', "Wrote back mapped page %u (%u bytes).\n", vpn, toWrite);
+}
+
+void
+AddressSpace::WriteBackMapping(MappedFile *mapping)
+{
+    ASSERT(mapping != nullptr);
+
+    for (unsigned i = 0; i < mapping->numPages; i++)
+    {
+        unsigned vpn = mapping->firstPage + i;
+        TranslationEntry *entry = &pageTable[vpn];
+        if (!entry->valid)
+        {
+            continue;
+        }
+        if (entry->dirty)
+        {
+            WriteBackPage(mapping, vpn);
+        }
+        coreMap->Release(entry->physicalPage, this, vpn);
+        entry->valid = false;
+        entry->dirty = false;
+    }
+}
+
+int
+AddressSpace::AllocateFrame(unsigned vpn)
+{
+    return FindFrame(this, vpn);
+}
+
+int
+AddressSpace::AllocateKernelFrame()
+{
+    return FindFrame(nullptr, 0);
+}
+
+int
+AddressSpace::FindFrame(AddressSpace *space, unsigned vpn)
+{
+    int frame = coreMap->Find(space, vpn);
+#ifdef VMEM
+    if (frame == -1)
+    {
+#ifdef USE_TLB
+        // The clock looks at `use` bits, which may still be in the TLB.
+        if (loaded != nullptr)
+        {
+            loaded->SyncTlb();
+        }
+#endif
+        int victim = coreMap->FindVictim();
+        if (victim == -1)
+        {
+            return -1;
+        }
+        const FrameOwner *owner = coreMap->GetOwners(victim);
+        owner->space->EvictPage(owner->vpn);
+        frame = coreMap->Find(space, vpn);
+        ASSERT(frame == victim);
+    }
+#endif
+    return frame;
 }
 
+#ifdef VMEM
+void
+AddressSpace::EvictPage(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+
+    TranslationEntry *entry = &pageTable[vpn];
+    ASSERT(entry->valid);
+
+    InvalidatePage(vpn);
+
+    unsigned frame = entry->physicalPage;
+    MappedFile *mapping = FindMapping(vpn);
+    coreMap->Pin(frame);
+    if (mapping == nullptr && compressedCache != nullptr
+        && compressedCache->Store(this, vpn,
+               &machine->GetMMU()->mainMemory[frame * PAGE_SIZE],
+               entry->dirty))
+    {
+        // Kept in memory; the swap file is only written if the page is
+        // pushed out of the cache.
+    }
+    else if (entry->dirty)
+    {
+        if (mapping != nullptr)
+        {
+            WriteBackPage(mapping, vpn);
+        }
+        else
+        {
+            WriteSwapCluster(vpn);
+        }
+    }
+    coreMap->Unpin(frame);
+    if (prefetched[vpn])
+    {
+        prefetched[vpn] = false;
+        stats->numPrefetchWasted++;
+    }
+    if (coreMap->IsCopyOnWrite(frame))
+    {
+        // The page comes back in a frame of its own.
+        entry->readOnly = false;
+    }
+
+    coreMap->Release(frame, this, vpn);
+    entry->valid = false;
+    entry->use = false;
+    entry->dirty = false;
+    DEBUG('a', "Evicted virtual page %u from frame %u.\n", vpn, frame);
+}
+
+void
+AddressSpace::SampleWorkingSet()
+{
+#ifdef USE_TLB
+    if (IsLoaded())
+    {
+        SyncTlb();
+    }
+#endif
+    workingSet->Sample(pageTable);
+}
+
+WorkingSet *
+AddressSpace::GetWorkingSet() const
+{
+    return workingSet;
+}
+
+void
+AddressSpace::WriteSwapPages(unsigned vpn, unsigned count, const char *data)
+{
+    ASSERT(vpn + count <= swapPages);
+    ASSERT(data != nullptr);
+
+    swapFile->WriteAt(data, count * PAGE_SIZE, vpn * PAGE_SIZE);
+    stats->numSwapWrites++;
+    stats->numPagesSwappedOut += count;
+    DEBUG('a', "Swapped out virtual pages %u to %u from the compressed "
+          "cache.\n", vpn, vpn + count - 1);
+}
+
+bool
+AddressSpace::IsCompressed(unsigned vpn) const
+{
+    return compressedCache != nullptr && compressedCache->Contains(this, vpn);
+}
+
+void
+AddressSpace::WriteSwapCluster(unsigned vpn)
+{
+    ASSERT(vpn < swapPages);
+
+    // Dirty neighbours in the same cluster are cleaned along with the
+    // victim, in a single transfer.
+    unsigned start = vpn - vpn % SWAP_CLUSTER_PAGES;
+    unsigned end = start + SWAP_CLUSTER_PAGES < swapPages
+                   ? start + SWAP_CLUSTER_PAGES : swapPages;
+    unsigned first = vpn, last = vpn;
+    while (first > start && pageTable[first - 1].valid
+           && pageTable[first - 1].dirty)
+    {
+        first--;
+    }
+    while (last + 1 < end && pageTable[last + 1].valid
+           && pageTable[last + 1].dirty)
+    {
+        last++;
+    }
+
+    unsigned count = last - first + 1;
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    char *buffer = new char[count * PAGE_SIZE];
+    for (unsigned i = first; i <= last; i++)
+    {
+        memcpy(&buffer[(i - first) * PAGE_SIZE],
+               &mainMemory[pageTable[i].physicalPage * PAGE_SIZE], PAGE_SIZE);
+        pageTable[i].dirty = false;
+    }
+    swapFile->WriteAt(buffer, count * PAGE_SIZE, first * PAGE_SIZE);
+    delete[] buffer;
+
+#ifdef USE_TLB
+    if (IsLoaded())
+    {
+        TranslationEntry *tlb = machine->GetMMU()->tlb;
+        for (unsigned i = 0; i < TLB_SIZE; i++)
+        {
+            if (tlb[i].valid && tlb[i].virtualPage >= first
+                && tlb[i].virtualPage <= last)
+            {
+                tlb[i].dirty = false;
+            }
+        }
+    }
+#endif
+
+    stats->numSwapWrites++;
+    stats->numPagesSwappedOut += count;
+    DEBUG('a', "Swapped out virtual pages %u to %u.\n", first, last);
+}
+
+bool
+AddressSpace::LoadSwappedPage(unsigned vpn)
+{
+    ASSERT(vpn < swapPages);
+
+    int frame = AllocateFrame(vpn);
+    if (frame == -1)
+    {
+        DEBUG('a', "No frame can be evicted for page %u.\n", vpn);
+        return false;
+    }
+
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    bool dirty;
+    if (compressedCache != nullptr
+        && compressedCache->Load(this, vpn, &mainMemory[frame * PAGE_SIZE],
+                                 &dirty))
+    {
+        pageTable[vpn].physicalPage = frame;
+        pageTable[vpn].valid = true;
+        pageTable[vpn].use = false;
+        pageTable[vpn].dirty = dirty;
+        prefetched[vpn] = false;
+        DEBUG('a', "Decompressed virtual page %u to frame %d.\n", vpn, frame);
+        return true;
+    }
+
+    // Read around the faulting page: absent neighbours in the same cluster
+    // come in with it, as long as there are free frames for them.  Nothing
+    // is evicted to make room for a guess.
+    unsigned start = vpn - vpn % SWAP_CLUSTER_PAGES;
+    unsigned end = start + SWAP_CLUSTER_PAGES < swapPages
+                   ? start + SWAP_CLUSTER_PAGES : swapPages;
+    unsigned available = coreMap->CountClear();
+    unsigned first = vpn, last = vpn;
+    while (available > 0 && last + 1 < end && !pageTable[last + 1].valid
+           && !IsCompressed(last + 1))
+    {
+        last++;
+        available--;
+    }
+    while (available > 0 && first > start && !pageTable[first - 1].valid
+           && !IsCompressed(first - 1))
+    {
+        first--;
+        available--;
+    }
+
+    unsigned count = last - first + 1;
+    char *buffer = new char[count * PAGE_SIZE];
+    coreMap->Pin(frame);
+    swapFile->ReadAt(buffer, count * PAGE_SIZE, first * PAGE_SIZE);
+    coreMap->Unpin(frame);
+    stats->numSwapReads++;
+    stats->numPagesSwappedIn += count;
+
+    for (unsigned i = first; i <= last; i++)
+    {
+        int f = i == vpn ? frame : coreMap->Find(this, i);
+        ASSERT(f != -1);
+        memcpy(&mainMemory[f * PAGE_SIZE], &buffer[(i - first) * PAGE_SIZE],
+               PAGE_SIZE);
+        pageTable[i].physicalPage = f;
+        pageTable[i].valid = true;
+        pageTable[i].use = false;
+        pageTable[i].dirty = false;
+        prefetched[i] = i != vpn;
+    }
+    delete[] buffer;
+
+    DEBUG('a', "Swapped in virtual page %u to frame %d, with pages %u to %u.\n",
+          vpn, frame, first, last);
+    return true;
+}
+#endif
+
+bool
+AddressSpace::LoadPage(unsigned vpn)
+{
+    if (vpn >= numPages)
+    {
+        return false;
+    }
+
+    if (!pageTable[vpn].valid)
+    {
+        MappedFile *mapping = FindMapping(vpn);
+        if (mapping != nullptr)
+        {
+            if (!LoadMappedPage(mapping, vpn))
+            {
+                return false;
+            }
+        }
+#ifdef VMEM
+        else if (vpn < swapPages)
+        {
+            if (!LoadSwappedPage(vpn))
+            {
+                return false;
+            }
+        }
+#endif
+        else
+        {
+            return false;
+        }
+    }
+#ifdef VMEM
+    else if (vpn < swapPages && prefetched[vpn])
+    {
+        // First reference to a page that was read around another one.
+        prefetched[vpn] = false;
+        stats->numPrefetchUseful++;
+    }
+#endif
+
+#ifdef USE_TLB
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    TranslationEntry *victim = &tlb[nextTlbEntry];
+    if (victim->valid)
+    {
+        pageTable[victim->virtualPage].use |= victim->use;
+        pageTable[victim->virtualPage].dirty |= victim->dirty;
+    }
+    *victim = pageTable[vpn];
+    nextTlbEntry = (nextTlbEntry + 1) % TLB_SIZE;
+#endif
+    return true;
+}
+
+#ifdef USE_TLB
+void
+AddressSpace::SyncTlb()
+{
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < TLB_SIZE; i++)
+    {
+        if (tlb[i].valid)
+        {
+            pageTable[tlb[i].virtualPage].use |= tlb[i].use;
+            pageTable[tlb[i].virtualPage].dirty |= tlb[i].dirty;
+            // Harvested, so that page replacement can clear it.
+            tlb[i].use = false;
+        }
+    }
+}
+#endif
+
 /// Set the initial values for the user-level register set.
 ///
 /// We write these directly into the “machine” registers, so that we can
-/// immediately jump to user code.  Note that these will be saved/restored
-/// into the `currentThread->userRegisters` when this thread is context
-/// switched out.
+/// immediately jump to user code.  Those are the `userRegisters` of the
+/// current thread, which the machine uses in place.
 void AddressSpace::InitRegisters()
 {
     for (unsigned i = 0; i < NUM_TOTAL_REGS; i++)
@@ -189,17 +1022,66 @@ void AddressSpace::InitRegisters()
 /// On a context switch, save any machine state, specific to this address
 /// space, that needs saving.
 ///
-/// For now, nothing!
+/// With a TLB, the bits set by the hardware are copied into the page table.
 void AddressSpace::SaveState()
 {
+#ifdef USE_TLB
+    SyncTlb();
+#endif
 }
 
 /// On a context switch, restore the machine state so that this address space
 /// can run.
 ///
-/// For now, tell the machine where to find the page table.
+/// Without a TLB, tell the machine where to find the page table; with a
+/// TLB, invalidate its entries so that they get reloaded on demand.
+///
+/// Also called to install the page table again after it changed.
 void AddressSpace::RestoreState()
 {
+    if (loaded != nullptr && loaded != this)
+    {
+        loaded->SaveState();
+    }
+    loaded = this;
+
+    machine->GetMMU()->asid = asid;
+#ifdef USE_TLB
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < TLB_SIZE; i++)
+    {
+        tlb[i].valid = false;
+    }
+#else
     machine->GetMMU()->pageTable = pageTable;
     machine->GetMMU()->pageTableSize = numPages;
+#endif
+}
+
+bool AddressSpace::IsLoaded() const
+{
+    return loaded == this;
+}
+
+/// Without a TLB the machine reads the page table itself, so there is
+/// nothing to do.  With it, the bits set by the hardware are kept first.
+void AddressSpace::InvalidatePage(unsigned vpn)
+{
+    ASSERT(vpn < numPages);
+
+#ifdef USE_TLB
+    if (!IsLoaded())
+    {
+        return;
+    }
+    SyncTlb();
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < TLB_SIZE; i++)
+    {
+        if (tlb[i].valid && tlb[i].virtualPage == vpn)
+        {
+            tlb[i].valid = false;
+        }
+    }
+#endif
 }
@@ -16,10 +16,48 @@
 
 #include "filesys/file_system.hh"
 #include "machine/translation_entry.hh"
+#include "userprog/shared_memory.hh"
+#ifdef VMEM
+#include "vmem/working_set.hh"
+#endif
+#include "lib/table.hh"
 
 
 const unsigned USER_STACK_SIZE = 1024;  ///< Increase this as necessary!
 
+/// Pages an address space may grow to with mapped files and shared
+/// segments, so that a process cannot take all of the host memory with
+/// page tables.
+const unsigned MAX_USER_PAGES = 8192;
+
+#ifdef VMEM
+/// Pages are read from and written to swap in aligned clusters of up to
+/// this many pages.
+const unsigned SWAP_CLUSTER_PAGES = 8;
+#endif
+
+
+/// A region of an open file mapped into an address space by `Mmap`.
+///
+/// Pages of the region are not loaded until they are referenced, and dirty
+/// pages are written back to the file when the region is unmapped.
+class MappedFile {
+public:
+    OpenFile *file;      ///< The file backing the region.
+    int fileId;          ///< Identifier of the file in the owner's table.
+    unsigned firstPage;  ///< First virtual page of the region.
+    unsigned numPages;   ///< Number of virtual pages in the region.
+    unsigned length;     ///< Number of bytes of the file that are mapped.
+};
+
+
+/// A shared-memory segment attached to an address space.
+class SharedMapping {
+public:
+    SharedSegment *segment;  ///< The segment, owned by `sharedMemory`.
+    unsigned firstPage;      ///< First virtual page of the segment.
+};
+
 
 class AddressSpace {
 public:
@@ -43,11 +81,99 @@ public:
     void InitRegisters();
 
     /// Save/restore address space-specific info on a context switch.
+    ///
+    /// `RestoreState` installs the address space in the MMU, saving the
+    /// one that was there first.
 
     void SaveState();
     void RestoreState();
 
+    /// Is this the address space installed in the MMU?
+    ///
+    /// It stays installed while threads that only run in the kernel use the
+    /// CPU, so this may be true even if the current thread has no address
+    /// space at all.
+    bool IsLoaded() const;
+
+    /// Make the MMU forget its translation of page `vpn`, whose entry in
+    /// the page table is about to change.
+    ///
+    /// The TLB keeps serving translations of the loaded space until they
+    /// are dropped, even while other threads run; whoever changes the page
+    /// table behind the back of its threads has to call this first.
+    void InvalidatePage(unsigned vpn);
+
+    /// Map the first `length` bytes of `file` after the current end of the
+    /// address space.
+    ///
+    /// Returns the virtual address of the mapping, or 0 on failure: if the
+    /// file is shorter than `length`, or the address space would grow
+    /// beyond `MAX_USER_PAGES`.
+    unsigned MapFile(OpenFile *file, int fileId, unsigned length);
+
+    /// Remove the mapping that starts at `virtualAddr`, writing back every
+    /// dirty page to the file.
+    ///
+    /// Returns false if no mapping starts at that address.
+    bool UnmapFile(unsigned virtualAddr);
+
+    /// Remove every mapping, writing back their dirty pages.
+    void UnmapAll();
+
+    /// Check whether the file open as `fileId` has some mapped region.
+    bool IsMapped(int fileId) const;
+
+    /// Map the frames of `segment` after the current end of the address
+    /// space.
+    ///
+    /// Returns the virtual address of the segment, or 0 on failure.
+    unsigned AttachSegment(SharedSegment *segment);
+
+    /// Unmap the segment attached at `virtualAddr`.
+    ///
+    /// Returns false if no segment is attached at that address.
+    bool DetachSegment(unsigned virtualAddr);
+
+    /// Give the page `vpn` a private copy of its copy-on-write frame.
+    ///
+    /// Returns false if the page is not copy-on-write, or there is no memory
+    /// left for the copy.
+    bool BreakCopyOnWrite(unsigned vpn);
+
+    /// Number of pages in the virtual address space.
+    unsigned GetNumPages() const;
+
+    /// Page table entry of the virtual page `vpn`.
+    TranslationEntry *GetPageEntry(unsigned vpn) const;
+
+#ifdef VMEM
+    /// Take a sample of the pages referenced since the previous one.
+    void SampleWorkingSet();
+
+    WorkingSet *GetWorkingSet() const;
+
+    /// Write `data` to the swap file as the contents of `count` pages
+    /// starting at `vpn`, in a single transfer.
+    void WriteSwapPages(unsigned vpn, unsigned count, const char *data);
+#endif
+
+    /// Make the virtual page `vpn` accessible to the machine, bringing it
+    /// into memory if needed.
+    ///
+    /// Returns false if the page does not belong to the address space.
+    bool LoadPage(unsigned vpn);
+
+    /// Get a frame held by the kernel rather than by some page, like those
+    /// of shared-memory segments, evicting some page if memory is full and
+    /// there is virtual memory.
+    ///
+    /// Returns -1 if no frame could be found.
+    static int AllocateKernelFrame();
+
 private:
+    /// The address space installed in the MMU, if any.
+    static AddressSpace *loaded;
+
     /// Assume linear page table translation for now!
     TranslationEntry *pageTable;
 
@@ -56,6 +182,88 @@ private:
     /// Number of pages in the virtual address space.
     unsigned numPages;
 
+    /// Identifier of the address space, used to name its swap file and in
+    /// memory traces.
+    unsigned asid;
+
+    /// Regions created by `MapFile`.
+    Table<MappedFile *> *mappedFiles;
+
+    /// Segments attached by `AttachSegment`.
+    Table<SharedMapping *> *sharedMappings;
+
+    /// Can `count` pages be appended without going beyond
+    /// `MAX_USER_PAGES`?
+    bool CanGrow(unsigned count) const;
+
+    /// Append `count` invalid pages to the page table.
+    ///
+    /// Returns the number of the first new page.
+    unsigned GrowPageTable(unsigned count);
+
+    /// Drop the pages of `mapping` and its attachment to the segment.
+    void ReleaseSegment(SharedMapping *mapping);
+
+    /// Find the mapped region that contains the virtual page `vpn`.
+    MappedFile *FindMapping(unsigned vpn) const;
+
+    /// Read a page of a mapped region from its file into a fresh frame.
+    bool LoadMappedPage(MappedFile *mapping, unsigned vpn);
+
+    /// Write the page `vpn` of `mapping` back to its file.
+    void WriteBackPage(MappedFile *mapping, unsigned vpn);
+
+    /// Write every dirty page of `mapping` back to its file and free its
+    /// frames.
+    void WriteBackMapping(MappedFile *mapping);
+
+    /// Get a frame for the page `vpn`, evicting some other page if memory
+    /// is full and there is virtual memory.
+    ///
+    /// Returns -1 if no frame could be found.
+    int AllocateFrame(unsigned vpn);
+
+    /// Get a frame for the page `vpn` of `space`, or for the kernel if
+    /// `space` is null, as `AllocateFrame` does.
+    static int FindFrame(AddressSpace *space, unsigned vpn);
+
+#ifdef VMEM
+    /// Write the page `vpn` to its backing store if it is dirty, and give
+    /// its frame back.
+    void EvictPage(unsigned vpn);
+
+    /// Write the dirty page `vpn` to the swap file, together with the dirty
+    /// pages next to it in its cluster.
+    void WriteSwapCluster(unsigned vpn);
+
+    /// Read the page `vpn` from the compressed cache or the swap file into
+    /// a fresh frame; in the latter case, together with the absent pages
+    /// next to it in its cluster.
+    bool LoadSwappedPage(unsigned vpn);
+
+    /// Whether the page `vpn` is held by the compressed cache, so that the
+    /// swap file may have an old copy.
+    bool IsCompressed(unsigned vpn) const;
+
+    /// Backing store of every page of the program image and the stack.
+    OpenFile *swapFile;
+    char swapName[16];
+
+    /// Number of pages backed by `swapFile`.
+    unsigned swapPages;
+
+    WorkingSet *workingSet;
+
+    /// Pages read around a fault and not referenced yet.
+    bool *prefetched;
+#endif
+
+#ifdef USE_TLB
+    /// Copy the `use` and `dirty` bits set by the hardware in the TLB back
+    /// into the page table.
+    void SyncTlb();
+#endif
+
 };
 
 
@@ -0,0 +1,236 @@
+/// Routines to manage the frame table.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "core_map.hh"
+#include "address_space.hh"
+#include "threads/system.hh"
+#include "machine/system_dep.hh"
+
+
+CoreMap::CoreMap(unsigned numFrames_)
+{
+    ASSERT(numFrames_ > 0);
+
+    numFrames = numFrames_;
+    frames = new Bitmap(numFrames);
+    info = (FrameInfo *) SystemDep::AllocZeroedMemory(
+               (size_t) numFrames * sizeof *info);
+#ifdef VMEM
+    clockHand = 0;
+#endif
+}
+
+CoreMap::~CoreMap()
+{
+    for (unsigned i = 0; i < numFrames; i++) {
+        while (info[i].owners != nullptr) {
+            FrameOwner *owner = info[i].owners;
+            info[i].owners = owner->next;
+            delete owner;
+        }
+    }
+    delete frames;
+    SystemDep::DeallocZeroedMemory((char *) info,
+                                   (size_t) numFrames * sizeof *info);
+}
+
+int
+CoreMap::Find(AddressSpace *space, unsigned vpn)
+{
+    int frame = frames->Find();
+    if (frame == -1) {
+        return -1;
+    }
+
+    ASSERT(info[frame].refCount == 0);
+    ASSERT(info[frame].owners == nullptr);
+    info[frame].refCount = 0;
+    info[frame].copyOnWrite = false;
+    info[frame].pinCount = 0;
+    Share(frame, space, vpn);
+    return frame;
+}
+
+void
+CoreMap::Share(unsigned which, AddressSpace *space, unsigned vpn)
+{
+    ASSERT(which < numFrames);
+    ASSERT(frames->Test(which));
+
+    info[which].refCount++;
+    info[which].lastUse = stats->totalTicks;
+    if (space != nullptr) {
+        FrameOwner *owner = new FrameOwner;
+        owner->space = space;
+        owner->vpn = vpn;
+        owner->next = info[which].owners;
+        info[which].owners = owner;
+    }
+}
+
+void
+CoreMap::Release(unsigned which, AddressSpace *space, unsigned vpn)
+{
+    ASSERT(which < numFrames);
+    ASSERT(info[which].refCount > 0);
+
+    if (space != nullptr) {
+        FrameOwner **p = &info[which].owners;
+        while (*p != nullptr
+                 && ((*p)->space != space || (*p)->vpn != vpn)) {
+            p = &(*p)->next;
+        }
+        ASSERT(*p != nullptr);  // The page must be among the owners.
+        FrameOwner *owner = *p;
+        *p = owner->next;
+        delete owner;
+    }
+
+    if (--info[which].refCount == 0) {
+        ASSERT(info[which].owners == nullptr);
+        ASSERT(info[which].pinCount == 0);
+        info[which].copyOnWrite = false;
+        frames->Clear(which);
+    }
+}
+
+unsigned
+CoreMap::GetRefCount(unsigned which) const
+{
+    ASSERT(which < numFrames);
+
+    return info[which].refCount;
+}
+
+const FrameOwner *
+CoreMap::GetOwners(unsigned which) const
+{
+    ASSERT(which < numFrames);
+
+    return info[which].owners;
+}
+
+void
+CoreMap::SetCopyOnWrite(unsigned which)
+{
+    ASSERT(which < numFrames);
+    ASSERT(info[which].refCount > 0);
+
+    info[which].copyOnWrite = true;
+}
+
+void
+CoreMap::ClearCopyOnWrite(unsigned which)
+{
+    ASSERT(which < numFrames);
+    ASSERT(info[which].refCount == 1);
+
+    info[which].copyOnWrite = false;
+}
+
+bool
+CoreMap::IsCopyOnWrite(unsigned which) const
+{
+    ASSERT(which < numFrames);
+
+    return info[which].copyOnWrite;
+}
+
+void
+CoreMap::Pin(unsigned which)
+{
+    ASSERT(which < numFrames);
+    ASSERT(info[which].refCount > 0);
+
+    info[which].pinCount++;
+}
+
+void
+CoreMap::Unpin(unsigned which)
+{
+    ASSERT(which < numFrames);
+    ASSERT(info[which].pinCount > 0);
+
+    info[which].pinCount--;
+}
+
+unsigned long
+CoreMap::GetLastUse(unsigned which) const
+{
+    ASSERT(which < numFrames);
+
+    return info[which].lastUse;
+}
+
+void
+CoreMap::Touch(unsigned which)
+{
+    ASSERT(which < numFrames);
+
+    info[which].lastUse = stats->totalTicks;
+}
+
+unsigned
+CoreMap::CountClear() const
+{
+    return frames->CountClear();
+}
+
+unsigned
+CoreMap::GetNumFrames() const
+{
+    return numFrames;
+}
+
+/// A kernel reference is one with no owning page, so a frame has one when
+/// it has more references than owners.
+unsigned
+CoreMap::CountReserved() const
+{
+    unsigned reserved = 0;
+    for (unsigned i = 0; i < numFrames; i++) {
+        if (info[i].refCount == 0) {
+            continue;
+        }
+        unsigned numOwners = 0;
+        for (const FrameOwner *o = info[i].owners; o != nullptr; o = o->next) {
+            numOwners++;
+        }
+        if (info[i].pinCount > 0 || info[i].refCount > numOwners) {
+            reserved++;
+        }
+    }
+    return reserved;
+}
+
+#ifdef VMEM
+int
+CoreMap::FindVictim()
+{
+    // Two turns are enough: the first one clears every `use` bit.
+    for (unsigned i = 0; i < 2 * numFrames; i++) {
+        unsigned frame = clockHand;
+        clockHand = (clockHand + 1) % numFrames;
+
+        FrameInfo *f = &info[frame];
+        if (f->refCount != 1 || f->pinCount > 0 || f->owners == nullptr) {
+            continue;
+        }
+
+        TranslationEntry *entry = f->owners->space->GetPageEntry(f->owners->vpn);
+        if (entry->use) {
+            entry->use = false;
+            Touch(frame);
+            continue;
+        }
+
+        DEBUG('a', "Evicting frame %u, virtual page %u.\n",
+              frame, f->owners->vpn);
+        return frame;
+    }
+    return -1;
+}
+#endif
@@ -0,0 +1,136 @@
+/// Data structures to keep track of the physical page frames of the
+/// machine.
+///
+/// The same frame may be mapped by several page tables at once (for
+/// instance, a shared-memory segment attached by many processes), so every
+/// frame carries a reference count and it is only freed when the last
+/// mapping goes away.
+///
+/// The core map also records which pages map every frame (its reverse
+/// mapping), so that a frame can be evicted or invalidated without looking
+/// through the page table of every process.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_COREMAP__HH
+#define NACHOS_USERPROG_COREMAP__HH
+
+
+#include "lib/bitmap.hh"
+
+
+class AddressSpace;
+
+/// A virtual page that maps a frame.
+class FrameOwner {
+public:
+    AddressSpace *space;
+    unsigned vpn;
+    FrameOwner *next;  ///< Next owner of the same frame, if any.
+};
+
+
+/// The frame table: which frames are free, how many page table entries
+/// refer to each of the frames in use, and which ones.
+class CoreMap {
+public:
+
+    /// Initialize a core map for `numFrames` frames, all of them free.
+    CoreMap(unsigned numFrames);
+
+    ~CoreMap();
+
+    /// Allocate a free frame with a reference count of one, mapped by the
+    /// page `vpn` of `space`.
+    ///
+    /// References held by the kernel rather than by some page, like those
+    /// of shared-memory segments, have no `space`.
+    ///
+    /// Returns -1 if every frame is in use.
+    int Find(AddressSpace *space = nullptr, unsigned vpn = 0);
+
+    /// Add a reference to the frame `which`, which must be in use.
+    void Share(unsigned which, AddressSpace *space = nullptr,
+               unsigned vpn = 0);
+
+    /// Drop a reference to the frame `which`, freeing it once nobody refers
+    /// to it anymore.
+    void Release(unsigned which, AddressSpace *space = nullptr,
+                 unsigned vpn = 0);
+
+    /// Number of references to the frame `which`; zero if it is free.
+    unsigned GetRefCount(unsigned which) const;
+
+    /// Pages that map the frame `which`.
+    const FrameOwner *GetOwners(unsigned which) const;
+
+    /// Mark the frame `which` as copy-on-write: the pages that map it hold
+    /// private data that happens to be identical.
+    void SetCopyOnWrite(unsigned which);
+
+    /// Mark the frame `which` as private to its only page again.
+    void ClearCopyOnWrite(unsigned which);
+
+    bool IsCopyOnWrite(unsigned which) const;
+
+    /// Keep the frame `which` from being evicted, for instance while it is
+    /// being read from disk.  Pins nest.
+    void Pin(unsigned which);
+    void Unpin(unsigned which);
+
+    /// Tick of the last time the frame `which` was seen in use.
+    unsigned long GetLastUse(unsigned which) const;
+
+    /// Record that the frame `which` was seen in use now.
+    void Touch(unsigned which);
+
+    /// Number of free frames.
+    unsigned CountClear() const;
+
+    /// Number of frames, free or not.
+    unsigned GetNumFrames() const;
+
+    /// Number of frames that no page can be given by evicting them: those
+    /// pinned and those the kernel holds a reference to, like the frames
+    /// of shared-memory segments or of the compressed cache.
+    unsigned CountReserved() const;
+
+#ifdef VMEM
+    /// Choose a frame to be evicted, with the clock algorithm.
+    ///
+    /// Only frames mapped by a single page and not pinned are considered.
+    /// Returns -1 if there is none.
+    int FindVictim();
+#endif
+
+private:
+
+    class FrameInfo {
+    public:
+        unsigned refCount;
+        bool copyOnWrite;
+        unsigned pinCount;
+        unsigned long lastUse;
+        FrameOwner *owners;
+    };
+
+    unsigned numFrames;
+
+    /// Frames in use.
+    Bitmap *frames;
+
+    /// Bookkeeping of every frame.  All zeros stands for a free frame, so
+    /// that memory is only touched for frames that get used.
+    FrameInfo *info;
+
+#ifdef VMEM
+    /// Next frame to be examined by `FindVictim`.
+    unsigned clockHand;
+#endif
+
+};
+
+
+#endif
@@ -133,8 +133,9 @@ CommandDump(char **args, void *extra)
         return DCM::RUN_RESULT_STAY;
     }
 
-    int rv = fwrite(machine->GetMMU()->mainMemory, 1, MEMORY_SIZE, f);
-    if (rv != MEMORY_SIZE) {
+    MMU *mmu = machine->GetMMU();
+    size_t rv = fwrite(mmu->mainMemory, 1, mmu->memorySize, f);
+    if (rv != mmu->memorySize) {
         fprintf(stderr, "ERROR: write to file `%s` did not succeed.\n",
                 path);
         return DCM::RUN_RESULT_STAY;
@@ -213,7 +214,7 @@ CommandPrint(char **args, void *extra)
             }
 
         } else if (strcmp(end, "@p") == 0) {
-            if (address >= MEMORY_SIZE) {
+            if (address >= machine->GetMMU()->memorySize) {
                 fprintf(stderr, "ERROR: address %u is too big.\n", address);
                 return DCM::RUN_RESULT_STAY;
             }
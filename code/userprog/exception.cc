@@ -25,6 +25,7 @@
 #include "transfer.hh"
 #include "syscall.h"
 #include "filesys/directory_entry.hh"
+#include "lib/slab.hh"
 
 #include <stdio.h>
 
@@ -238,6 +239,13 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
+        if (currentThread->space->IsMapped(fileId))
+        {
+            DEBUG('e', "Error: file %d is mapped and cannot be closed.\n", fileId);
+            machine->WriteRegister(2, -1);
+            break;
+        }
+
         if (currentThread->HasFile(fileId))
         {
             currentThread->RemoveFile(fileId);
@@ -285,7 +293,7 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
-        char* string = new char[size + 1];
+        char* string = AllocBuffer(size + 1);
         int read = 0;
         if (fileId != CONSOLE_INPUT)
         {
@@ -293,7 +301,7 @@ SyscallHandler(ExceptionType _et)
             {
                 DEBUG('e', "Error: file %d is not open for current thread.\n", fileId);
                 machine->WriteRegister(2, -1);
-                delete[] string;
+                FreeBuffer(string, size + 1);
                 break;
             }
             OpenFile* file = currentThread->GetFile(fileId);
@@ -313,7 +321,7 @@ SyscallHandler(ExceptionType _et)
         WriteBufferToUser(string, bufferAddr, read);
         machine->WriteRegister(2, read);
 
-        delete[] string;
+        FreeBuffer(string, size + 1);
 
         break;
     }
@@ -349,7 +357,7 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
-        char* string = new char[size + 1];
+        char* string = AllocBuffer(size + 1);
 
         ReadBufferFromUser(bufferAddr, string, size);
 
@@ -360,7 +368,7 @@ SyscallHandler(ExceptionType _et)
             {
                 DEBUG('e', "Error: file %d is not open for current thread.\n", fileId);
                 machine->WriteRegister(2, -1);
-                delete[] string;
+                FreeBuffer(string, size + 1);
                 break;
             }
             OpenFile* file = currentThread->GetFile(fileId);
@@ -375,7 +383,7 @@ SyscallHandler(ExceptionType _et)
             writed = size;
         }
         machine->WriteRegister(2, writed);
-        delete[] string;
+        FreeBuffer(string, size + 1);
 
         break;
     }
@@ -470,6 +478,147 @@ SyscallHandler(ExceptionType _et)
     case SC_PS:
     {
         scheduler->Print();
+#ifdef VMEM
+        workingSetManager->Print();
+#endif
+        break;
+    }
+
+    case SC_MMAP:
+    {
+        int fileId = machine->ReadRegister(4);
+        int length = machine->ReadRegister(5);
+
+        if (length <= 0)
+        {
+            DEBUG('e', "Error: invalid length %d to map.\n", length);
+            machine->WriteRegister(2, 0);
+            break;
+        }
+        if (fileId == CONSOLE_INPUT || fileId == CONSOLE_OUTPUT
+            || fileId < 0 || !currentThread->HasFile(fileId))
+        {
+            DEBUG('e', "Error: file %d cannot be mapped.\n", fileId);
+            machine->WriteRegister(2, 0);
+            break;
+        }
+
+        OpenFile *file = currentThread->GetFile(fileId);
+        unsigned addr = currentThread->space->MapFile(file, fileId, length);
+        if (addr == 0)
+        {
+            DEBUG('e', "Error: cannot map %d bytes of file %d.\n",
+                  length, fileId);
+        }
+        else
+        {
+            DEBUG('e', "File %d mapped at 0x%X.\n", fileId, addr);
+        }
+        machine->WriteRegister(2, addr);
+        break;
+    }
+
+    case SC_MUNMAP:
+    {
+        int addr = machine->ReadRegister(4);
+
+        if (currentThread->space->UnmapFile(addr))
+        {
+            DEBUG('e', "Region at 0x%X unmapped.\n", addr);
+            machine->WriteRegister(2, 0);
+        }
+        else
+        {
+            DEBUG('e', "Error: no region mapped at 0x%X.\n", addr);
+            machine->WriteRegister(2, -1);
+        }
+        break;
+    }
+
+    case SC_SHM_CREATE:
+    case SC_SHM_ATTACH:
+    {
+        int nameAddr = machine->ReadRegister(4);
+        if (nameAddr == 0)
+        {
+            DEBUG('e', "Error: address to segment name is null.\n");
+            machine->WriteRegister(2, 0);
+            break;
+        }
+
+        char name[SHM_NAME_MAX_LEN + 1];
+        if (!ReadStringFromUser(nameAddr, name, sizeof name))
+        {
+            DEBUG('e', "Error: segment name too long (maximum is %u bytes).\n",
+                SHM_NAME_MAX_LEN);
+            machine->WriteRegister(2, 0);
+            break;
+        }
+
+        SharedSegment *segment;
+        if (scid == SC_SHM_CREATE)
+        {
+            int size = machine->ReadRegister(5);
+            if (size <= 0)
+            {
+                DEBUG('e', "Error: invalid segment size %d.\n", size);
+                machine->WriteRegister(2, 0);
+                break;
+            }
+            segment = sharedMemory->Create(name, size);
+        }
+        else
+        {
+            segment = sharedMemory->Attach(name);
+        }
+        if (segment == nullptr)
+        {
+            DEBUG('e', "Error: cannot get shared segment `%s`.\n", name);
+            machine->WriteRegister(2, 0);
+            break;
+        }
+
+        unsigned addr = currentThread->space->AttachSegment(segment);
+        if (addr == 0)
+        {
+            sharedMemory->Detach(segment);
+        }
+        DEBUG('e', "Shared segment `%s` attached at 0x%X.\n", name, addr);
+        machine->WriteRegister(2, addr);
+        break;
+    }
+
+    case SC_SHM_DETACH:
+    {
+        int addr = machine->ReadRegister(4);
+
+        if (currentThread->space->DetachSegment(addr))
+        {
+            DEBUG('e', "Shared segment at 0x%X detached.\n", addr);
+            machine->WriteRegister(2, 0);
+        }
+        else
+        {
+            DEBUG('e', "Error: no shared segment at 0x%X.\n", addr);
+            machine->WriteRegister(2, -1);
+        }
+        break;
+    }
+
+    case SC_SLEEP:
+    {
+        int ticks = machine->ReadRegister(4);
+        if (ticks < 0)
+        {
+            DEBUG('e', "Error: cannot sleep for %d ticks.\n", ticks);
+            machine->WriteRegister(2, -1);
+            break;
+        }
+
+        DEBUG('e', "Thread `%s` sleeps for %d ticks.\n",
+              currentThread->GetName(), ticks);
+        currentThread->SleepFor(ticks);
+        machine->WriteRegister(2, 0);
         break;
     }
 
@@ -481,14 +630,55 @@ SyscallHandler(ExceptionType _et)
     IncrementPC();
 }
 
-/// By default, only system calls have their own handler.  All other
+/// Handle a page fault: either the TLB has no entry for the page, or the
+/// page is part of a mapped file and has not been read yet.
+///
+/// The faulting instruction is not skipped, so it is retried once the page
+/// is available.
+static void
+PageFaultHandler(ExceptionType et)
+{
+    unsigned virtualAddr = machine->ReadRegister(BAD_VADDR_REG);
+    unsigned vpn = virtualAddr / PAGE_SIZE;
+
+    stats->numPageFaults++;
+#ifdef VMEM
+    currentThread->space->GetWorkingSet()->AddPageFault();
+#endif
+    DEBUG('a', "Page fault at address 0x%X, virtual page %u.\n",
+          virtualAddr, vpn);
+
+    if (!currentThread->space->LoadPage(vpn))
+    {
+        DefaultHandler(et);
+    }
+}
+
+/// Handle a write to a read-only page.
+///
+/// Pages merged by the deduplicator are mapped read-only, so the writer
+/// gets its own copy and the write is retried.  Writes to pages that are
+/// really read-only are still errors.
+static void
+ReadOnlyHandler(ExceptionType et)
+{
+    unsigned virtualAddr = machine->ReadRegister(BAD_VADDR_REG);
+
+    if (!currentThread->space->BreakCopyOnWrite(virtualAddr / PAGE_SIZE))
+    {
+        DefaultHandler(et);
+    }
+}
+
+/// By default, only system calls, page faults and writes to read-only pages
+/// have their own handler.  All other
 /// exception types are assigned the default handler.
 void SetExceptionHandlers()
 {
     machine->SetHandler(NO_EXCEPTION, &DefaultHandler);
     machine->SetHandler(SYSCALL_EXCEPTION, &SyscallHandler);
-    machine->SetHandler(PAGE_FAULT_EXCEPTION, &DefaultHandler);
-    machine->SetHandler(READ_ONLY_EXCEPTION, &DefaultHandler);
+    machine->SetHandler(PAGE_FAULT_EXCEPTION, &PageFaultHandler);
+    machine->SetHandler(READ_ONLY_EXCEPTION, &ReadOnlyHandler);
     machine->SetHandler(BUS_ERROR_EXCEPTION, &DefaultHandler);
     machine->SetHandler(ADDRESS_ERROR_EXCEPTION, &DefaultHandler);
     machine->SetHandler(OVERFLOW_EXCEPTION, &DefaultHandler);
@@ -0,0 +1,164 @@
+/// Routines to merge identical pages.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "page_dedup.hh"
+#include "address_space.hh"
+#include "threads/semaphore.hh"
+#include "threads/system.hh"
+
+#include <string.h>
+
+
+/// FNV-1a hash of a page.
+static unsigned
+HashPage(const char *page)
+{
+    unsigned hash = 2166136261u;
+    for (unsigned i = 0; i < PAGE_SIZE; i++) {
+        hash ^= (unsigned char) page[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+PageDeduplicator::PageDeduplicator()
+{
+    // Twice as many slots as frames keeps probe sequences short.
+    numCandidates = 2 * coreMap->GetNumFrames();
+    candidates = new Candidate [numCandidates];
+    wakeUp = new Semaphore("page dedup", 0);
+    sleeping = false;
+}
+
+PageDeduplicator::~PageDeduplicator()
+{
+    delete [] candidates;
+    delete wakeUp;
+}
+
+void
+PageDeduplicator::Start()
+{
+    Thread *t = new Thread("page dedup");
+    t->Fork(ScanThread, this);
+}
+
+void
+PageDeduplicator::Wake()
+{
+    if (sleeping) {
+        sleeping = false;
+        wakeUp->V();
+    }
+}
+
+void
+PageDeduplicator::ScanThread(void *arg)
+{
+    PageDeduplicator *dedup = (PageDeduplicator *) arg;
+
+    for (;;) {
+        if (dedup->Scan() == 0) {
+            dedup->sleeping = true;
+            dedup->wakeUp->P();
+        } else {
+            currentThread->Yield();
+        }
+    }
+}
+
+unsigned
+PageDeduplicator::Scan()
+{
+    // Page tables must not change under our feet.
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    for (unsigned i = 0; i < numCandidates; i++) {
+        candidates[i].used = false;
+    }
+
+    unsigned merged = 0;
+    for (unsigned i = 0; i < threadsTable->GetCapacity(); i++) {
+        if (!threadsTable->HasKey(i)) {
+            continue;
+        }
+        AddressSpace *space = threadsTable->Get(i)->space;
+        if (space == nullptr) {
+            continue;
+        }
+        for (unsigned vpn = 0; vpn < space->GetNumPages(); vpn++) {
+            if (MergePage(space, vpn)) {
+                merged++;
+            }
+        }
+    }
+
+    interrupt->SetLevel(oldLevel);
+
+    DEBUG('a', "Deduplication scan merged %u frames.\n", merged);
+    stats->numMergedFrames += merged;
+    return merged;
+}
+
+bool
+PageDeduplicator::MergePage(AddressSpace *space, unsigned vpn)
+{
+    ASSERT(space != nullptr);
+
+    TranslationEntry *entry = space->GetPageEntry(vpn);
+    if (!entry->valid) {
+        return false;
+    }
+
+    unsigned frame = entry->physicalPage;
+    bool copyOnWrite = coreMap->IsCopyOnWrite(frame);
+    if (coreMap->GetRefCount(frame) > 1 && !copyOnWrite) {
+        // Frames shared on purpose, such as shared memory, are left alone.
+        return false;
+    }
+
+    const char *mainMemory = machine->GetMMU()->mainMemory;
+    bool readOnly = entry->readOnly && !copyOnWrite;
+    unsigned hash = HashPage(&mainMemory[frame * PAGE_SIZE]);
+
+    unsigned slot = hash % numCandidates;
+    for (; candidates[slot].used; slot = (slot + 1) % numCandidates) {
+        Candidate *c = &candidates[slot];
+        if (c->frame == frame) {
+            return false;
+        }
+        if (c->hash != hash || c->readOnly != readOnly
+              || memcmp(&mainMemory[c->frame * PAGE_SIZE],
+                        &mainMemory[frame * PAGE_SIZE], PAGE_SIZE) != 0) {
+            continue;
+        }
+
+        // The spaces may be loaded, with their TLB still holding writable
+        // translations of these pages.
+        if (!readOnly && !coreMap->IsCopyOnWrite(c->frame)) {
+            coreMap->SetCopyOnWrite(c->frame);
+            for (const FrameOwner *o = coreMap->GetOwners(c->frame);
+                   o != nullptr; o = o->next) {
+                o->space->InvalidatePage(o->vpn);
+                o->space->GetPageEntry(o->vpn)->readOnly = true;
+            }
+        }
+        DEBUG('a', "Merging frame %u into frame %u.\n", frame, c->frame);
+        space->InvalidatePage(vpn);
+        coreMap->Share(c->frame, space, vpn);
+        entry->physicalPage = c->frame;
+        entry->readOnly = true;
+        bool freed = coreMap->GetRefCount(frame) == 1;
+        coreMap->Release(frame, space, vpn);
+        return freed;
+    }
+
+    candidates[slot].used = true;
+    candidates[slot].hash = hash;
+    candidates[slot].frame = frame;
+    candidates[slot].readOnly = readOnly;
+    return false;
+}
@@ -0,0 +1,72 @@
+/// Content-based page deduplication.
+///
+/// A kernel thread scans the page tables of every process looking for
+/// frames with identical contents, and merges them into a single frame.
+/// Writable pages that get merged become copy-on-write: they are mapped
+/// read-only, and the first write to one of them gives the writer its own
+/// copy again (see `AddressSpace::BreakCopyOnWrite`).
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_PAGEDEDUP__HH
+#define NACHOS_USERPROG_PAGEDEDUP__HH
+
+
+#include "machine/translation_entry.hh"
+
+
+class AddressSpace;
+class Semaphore;
+
+
+class PageDeduplicator {
+public:
+
+    PageDeduplicator();
+
+    ~PageDeduplicator();
+
+    /// Fork the scanning thread.
+    void Start();
+
+    /// Ask for a new scan, for instance because a program was loaded.
+    void Wake();
+
+    /// Scan every address space once, merging identical frames.
+    ///
+    /// Returns the number of frames that were freed.
+    unsigned Scan();
+
+private:
+
+    /// A frame seen during a scan, indexed by the hash of its contents.
+    struct Candidate {
+        bool used;
+        unsigned hash;
+        unsigned frame;
+        bool readOnly;  ///< Whether the page is really read-only.
+    };
+
+    /// Body of the scanning thread.
+    static void ScanThread(void *arg);
+
+    /// Merge the page `vpn` of `space` with an identical one already seen,
+    /// or remember it as a candidate for later pages.
+    ///
+    /// Returns true if a frame was freed.
+    bool MergePage(AddressSpace *space, unsigned vpn);
+
+    /// Open addressing table with `numCandidates` slots.
+    Candidate *candidates;
+    unsigned numCandidates;
+
+    /// The scanning thread sleeps here when a scan finds nothing to merge.
+    Semaphore *wakeUp;
+    bool sleeping;
+
+};
+
+
+#endif
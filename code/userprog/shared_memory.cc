@@ -0,0 +1,163 @@
+/// Routines to manage shared-memory segments.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "shared_memory.hh"
+#include "address_space.hh"
+#include "threads/system.hh"
+#include "lib/utility.hh"
+
+#include <string.h>
+
+
+SharedSegment::SharedSegment(const char *name_, unsigned numPages_)
+{
+    ASSERT(name_ != nullptr);
+    ASSERT(numPages_ > 0);
+
+    strncpy(name, name_, SHM_NAME_MAX_LEN);
+    name[SHM_NAME_MAX_LEN] = '\0';
+    numPages = numPages_;
+    attachCount = 0;
+
+    // Under virtual memory, pages of processes are evicted to make room;
+    // frames held by the kernel are never chosen for eviction afterwards.
+    char *mainMemory = machine->GetMMU()->mainMemory;
+    frames = new unsigned [numPages];
+    for (unsigned i = 0; i < numPages; i++) {
+        int frame = AddressSpace::AllocateKernelFrame();
+        if (frame == -1) {
+            while (i > 0) {
+                coreMap->Release(frames[--i]);
+            }
+            delete [] frames;
+            frames = nullptr;
+            return;
+        }
+        frames[i] = frame;
+        memset(&mainMemory[frame * PAGE_SIZE], 0, PAGE_SIZE);
+    }
+}
+
+SharedSegment::~SharedSegment()
+{
+    if (frames == nullptr) {
+        return;
+    }
+    for (unsigned i = 0; i < numPages; i++) {
+        coreMap->Release(frames[i]);
+    }
+    delete [] frames;
+}
+
+bool
+SharedSegment::IsValid() const
+{
+    return frames != nullptr;
+}
+
+const char *
+SharedSegment::GetName() const
+{
+    return name;
+}
+
+unsigned
+SharedSegment::GetNumPages() const
+{
+    return numPages;
+}
+
+unsigned
+SharedSegment::GetFrame(unsigned i) const
+{
+    ASSERT(IsValid());
+    ASSERT(i < numPages);
+
+    return frames[i];
+}
+
+SharedMemory::SharedMemory()
+{
+    segments = new Table<SharedSegment *>();
+}
+
+SharedMemory::~SharedMemory()
+{
+    for (unsigned i = 0; i < segments->GetCapacity(); i++) {
+        if (segments->HasKey(i)) {
+            delete segments->Remove(i);
+        }
+    }
+    delete segments;
+}
+
+int
+SharedMemory::Find(const char *name) const
+{
+    ASSERT(name != nullptr);
+
+    for (unsigned i = 0; i < segments->GetCapacity(); i++) {
+        if (segments->HasKey(i)
+              && strncmp(segments->Get(i)->GetName(), name,
+                         SHM_NAME_MAX_LEN) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+SharedSegment *
+SharedMemory::Create(const char *name, unsigned size)
+{
+    ASSERT(size > 0);
+
+    if (Find(name) != -1) {
+        DEBUG('a', "Shared segment `%s` already exists.\n", name);
+        return nullptr;
+    }
+
+    SharedSegment *segment = new SharedSegment(name,
+                                               DivRoundUp(size, PAGE_SIZE));
+    if (!segment->IsValid() || segments->Add(segment) == -1) {
+        DEBUG('a', "Cannot create shared segment `%s`.\n", name);
+        delete segment;
+        return nullptr;
+    }
+
+    DEBUG('a', "Created shared segment `%s`, %u pages.\n",
+          name, segment->GetNumPages());
+    segment->attachCount = 1;
+    return segment;
+}
+
+SharedSegment *
+SharedMemory::Attach(const char *name)
+{
+    int i = Find(name);
+    if (i == -1) {
+        return nullptr;
+    }
+
+    SharedSegment *segment = segments->Get(i);
+    segment->attachCount++;
+    return segment;
+}
+
+void
+SharedMemory::Detach(SharedSegment *segment)
+{
+    ASSERT(segment != nullptr);
+    ASSERT(segment->attachCount > 0);
+
+    if (--segment->attachCount > 0) {
+        return;
+    }
+
+    int i = Find(segment->GetName());
+    ASSERT(i != -1);
+    DEBUG('a', "Destroying shared segment `%s`.\n", segment->GetName());
+    delete segments->Remove(i);
+}
@@ -0,0 +1,90 @@
+/// Named shared-memory segments.
+///
+/// A segment is a set of physical frames that is mapped into the page table
+/// of every process that attaches it, so that data written by one of them
+/// is immediately seen by the others without going through the kernel.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_SHAREDMEMORY__HH
+#define NACHOS_USERPROG_SHAREDMEMORY__HH
+
+
+#include "lib/table.hh"
+
+
+/// Maximum length of the name of a segment.
+const unsigned SHM_NAME_MAX_LEN = 15;
+
+
+class SharedSegment {
+public:
+
+    /// Allocate `numPages` zeroed frames for a segment called `name`.
+    ///
+    /// Check `IsValid` afterwards: it is false if there were not enough
+    /// frames, even after evicting every page that could be.
+    SharedSegment(const char *name, unsigned numPages);
+
+    /// Give the frames of the segment back to the core map.
+    ~SharedSegment();
+
+    bool IsValid() const;
+
+    const char *GetName() const;
+
+    unsigned GetNumPages() const;
+
+    /// Physical frame that backs the page `i` of the segment.
+    unsigned GetFrame(unsigned i) const;
+
+    /// Number of address spaces the segment is attached to.
+    unsigned attachCount;
+
+private:
+
+    char name[SHM_NAME_MAX_LEN + 1];
+
+    unsigned numPages;
+
+    /// Frames of the segment; `nullptr` if they could not be allocated.
+    unsigned *frames;
+
+};
+
+
+/// The set of segments that currently exist, looked up by name.
+class SharedMemory {
+public:
+
+    SharedMemory();
+
+    ~SharedMemory();
+
+    /// Create a segment of `size` bytes called `name` and attach it once.
+    ///
+    /// Returns `nullptr` if the name is taken, there are too many segments,
+    /// or there is not enough memory.
+    SharedSegment *Create(const char *name, unsigned size);
+
+    /// Attach the segment called `name`, if it exists.
+    SharedSegment *Attach(const char *name);
+
+    /// Drop an attachment of `segment`, destroying it when nobody uses it
+    /// anymore.
+    void Detach(SharedSegment *segment);
+
+private:
+
+    /// Find the segment called `name`, returning its index in `segments`
+    /// or -1.
+    int Find(const char *name) const;
+
+    Table<SharedSegment *> *segments;
+
+};
+
+
+#endif
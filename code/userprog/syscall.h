@@ -32,6 +32,12 @@
 #define SC_READ    14
 #define SC_WRITE   15
 #define SC_PS   16
+#define SC_MMAP    17
+#define SC_MUNMAP  18
+#define SC_SHM_CREATE  19
+#define SC_SHM_ATTACH  20
+#define SC_SHM_DETACH  21
+#define SC_SLEEP       22
 
 
 #ifndef IN_ASM
@@ -78,6 +84,11 @@ int Fork(void (*func)(void));
 /// or not.
 void Yield();
 
+/// Give up the CPU until `ticks` ticks of simulated time have gone by.
+///
+/// Return 0 on success, -1 if `ticks` is negative.
+int Sleep(int ticks);
+
 
 /// File system operations: `Create`, `Open`, `Read`, `Write`, `Close`.
 ///
@@ -127,6 +138,45 @@ int Close(OpenFileId id);
 void Ps();
 
 
+/// Memory-mapped files: `Mmap` and `Munmap`.
+
+/// Map the first `length` bytes of the open file `id` into the address
+/// space.  Pages are read from the file the first time they are touched.
+///
+/// Return the address of the mapping, or null on error.  The file cannot
+/// be closed while it is mapped.
+void *Mmap(OpenFileId id, int length);
+
+/// Unmap the region that starts at `addr`, writing modified pages back to
+/// the file.
+///
+/// Return 0 on success, -1 on error.
+int Munmap(void *addr);
+
+
+/// Shared memory: `ShmCreate`, `ShmAttach` and `ShmDetach`.
+///
+/// A segment is identified by its name, and its pages are mapped into every
+/// process that attaches it.  It is destroyed once the last process
+/// detaches it (exiting detaches every segment).
+
+/// Create a zero-filled segment of `size` bytes called `name` and attach
+/// it.
+///
+/// Return the address of the segment, or null on error.
+void *ShmCreate(const char *name, int size);
+
+/// Attach the segment called `name`, created by some other process.
+///
+/// Return the address of the segment, or null on error.
+void *ShmAttach(const char *name);
+
+/// Detach the segment attached at `addr`.
+///
+/// Return 0 on success, -1 on error.
+int ShmDetach(void *addr);
+
+
 #endif
 
 
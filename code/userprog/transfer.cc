@@ -6,6 +6,38 @@
 #include "lib/utility.hh"
 #include "threads/system.hh"
 
+/// Number of times an access to user memory is retried.
+///
+/// A failed access raises a page fault that brings the page in (or loads
+/// the TLB), so a second attempt should always succeed.
+static const unsigned MAX_MEMORY_RETRIES = 3;
+
+bool
+ReadUserMem(int userAddress, unsigned size, int *value)
+{
+    for (unsigned i = 0; i < MAX_MEMORY_RETRIES; i++)
+    {
+        if (machine->ReadMem(userAddress, size, value))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+WriteUserMem(int userAddress, unsigned size, int value)
+{
+    for (unsigned i = 0; i < MAX_MEMORY_RETRIES; i++)
+    {
+        if (machine->WriteMem(userAddress, size, value))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 void ReadBufferFromUser(int userAddress, char *outBuffer,
                         unsigned byteCount)
 {
@@ -17,7 +49,7 @@ void ReadBufferFromUser(int userAddress, char *outBuffer,
     do
     {
         int temp;
-        ASSERT(machine->ReadMem(userAddress++, 1, &temp));
+        ASSERT(ReadUserMem(userAddress++, 1, &temp));
         *outBuffer = (unsigned char)temp;
         count++;
         outBuffer++;
@@ -36,7 +68,7 @@ bool ReadStringFromUser(int userAddress, char *outString,
     {
         int temp;
         count++;
-        ASSERT(machine->ReadMem(userAddress++, 1, &temp));
+        ASSERT(ReadUserMem(userAddress++, 1, &temp));
         *outString = (unsigned char)temp;
     } while (*outString++ != '\0' && count < maxByteCount);
 
@@ -52,7 +84,7 @@ void WriteBufferToUser(const char *buffer, int userAddress,
     {
         for (unsigned count = 0; count < byteCount; count++)
         {
-            ASSERT(machine->WriteMem(userAddress++, 1, buffer[count]));
+            ASSERT(WriteUserMem(userAddress++, 1, buffer[count]));
         }
     }
 }
@@ -64,6 +96,6 @@ void WriteStringToUser(const char *string, int userAddress)
 
     for (unsigned count = 0; string[count] != '\0'; count++)
     {
-        ASSERT(machine->WriteMem(userAddress++, 1, string[count]));
+        ASSERT(WriteUserMem(userAddress++, 1, string[count]));
     }
 }
@@ -7,6 +7,16 @@
 #define NACHOS_USERPROG_TRANSFER__HH
 
 
+/// Read `size` bytes (1, 2 or 4) of user memory, retrying while the access
+/// faults the page in.
+///
+/// Returns false if it still fails after a few attempts.
+bool ReadUserMem(int userAddress, unsigned size, int *value);
+
+/// Write `size` bytes (1, 2 or 4) of user memory, retrying like
+/// `ReadUserMem`.
+bool WriteUserMem(int userAddress, unsigned size, int value);
+
 /// Copy a byte array from virtual machine to host.
 void ReadBufferFromUser(int userAddress, char *outBuffer,
                         unsigned byteCount);
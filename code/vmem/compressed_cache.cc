@@ -0,0 +1,345 @@
+/// Routines to keep evicted pages compressed in memory.
+///
+/// Pages are compressed with a small LZ77 variant: the output is a sequence
+/// of groups made of a flag byte followed by eight items, each either a
+/// literal byte (flag bit clear) or a two-byte back reference (flag bit
+/// set) holding a 12-bit distance and a 4-bit length, for copies of 3 to 18
+/// bytes.  Candidates for back references are found through a hash table
+/// of 3-byte prefixes, so compressing a page is a single pass.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "compressed_cache.hh"
+#include "userprog/address_space.hh"
+#include "threads/system.hh"
+
+#include <stdint.h>
+#include <string.h>
+
+
+static const unsigned MIN_MATCH = 3;
+static const unsigned MAX_MATCH = MIN_MATCH + 15;
+static const unsigned MAX_DISTANCE = 4095;
+static const unsigned HASH_SIZE = 256;
+
+/// Compress `size` bytes from `in` into at most `max` bytes at `out`.
+///
+/// Returns the compressed size, or 0 if it does not fit.
+static unsigned
+Compress(const unsigned char *in, unsigned size, unsigned char *out,
+         unsigned max)
+{
+    int table[HASH_SIZE];
+    for (unsigned i = 0; i < HASH_SIZE; i++) {
+        table[i] = -1;
+    }
+
+    unsigned pos = 0, o = 0;
+    while (pos < size) {
+        if (o + 1 > max) {
+            return 0;
+        }
+        unsigned flagPos = o++;
+        unsigned char flags = 0;
+
+        for (unsigned bit = 0; bit < 8 && pos < size; bit++) {
+            unsigned length = 0, distance = 0;
+            if (pos + MIN_MATCH <= size) {
+                unsigned h = (in[pos] * 33u * 33u + in[pos + 1] * 33u
+                              + in[pos + 2]) % HASH_SIZE;
+                int candidate = table[h];
+                table[h] = pos;
+                if (candidate >= 0 && pos - candidate <= MAX_DISTANCE
+                      && memcmp(&in[candidate], &in[pos], MIN_MATCH) == 0) {
+                    distance = pos - candidate;
+                    length = MIN_MATCH;
+                    while (length < MAX_MATCH && pos + length < size
+                           && in[candidate + length] == in[pos + length]) {
+                        length++;
+                    }
+                }
+            }
+
+            if (length > 0) {
+                if (o + 2 > max) {
+                    return 0;
+                }
+                out[o++] = (distance >> 8) << 4 | (length - MIN_MATCH);
+                out[o++] = distance & 0xFF;
+                flags |= 1 << bit;
+                pos += length;
+            } else {
+                if (o + 1 > max) {
+                    return 0;
+                }
+                out[o++] = in[pos++];
+            }
+        }
+        out[flagPos] = flags;
+    }
+    return o;
+}
+
+/// Expand data produced by `Compress` into exactly `size` bytes at `out`.
+static void
+Decompress(const unsigned char *in, unsigned char *out, unsigned size)
+{
+    unsigned i = 0, pos = 0;
+    while (pos < size) {
+        unsigned char flags = in[i++];
+        for (unsigned bit = 0; bit < 8 && pos < size; bit++) {
+            if (flags & 1 << bit) {
+                unsigned distance = (in[i] >> 4) << 8 | in[i + 1];
+                unsigned length = (in[i] & 0xF) + MIN_MATCH;
+                i += 2;
+                ASSERT(distance > 0 && distance <= pos);
+                ASSERT(pos + length <= size);
+                // Copies may overlap, so they go byte by byte.
+                for (unsigned k = 0; k < length; k++, pos++) {
+                    out[pos] = out[pos - distance];
+                }
+            } else {
+                out[pos++] = in[i++];
+            }
+        }
+    }
+}
+
+CompressedCache::CompressedCache(unsigned numFrames_)
+{
+    ASSERT(numFrames_ > 0);
+
+    numFrames = numFrames_;
+    frames = new int [numFrames];
+    for (unsigned i = 0; i < numFrames; i++) {
+        frames[i] = coreMap->Find();
+        ASSERT(frames[i] != -1);
+    }
+    usedSlots = new Bitmap(numFrames * SLOTS_PER_FRAME);
+
+    for (unsigned i = 0; i < NUM_BUCKETS; i++) {
+        buckets[i] = nullptr;
+    }
+    oldest = newest = nullptr;
+}
+
+CompressedCache::~CompressedCache()
+{
+    while (oldest != nullptr) {
+        Remove(oldest);
+    }
+    for (unsigned i = 0; i < numFrames; i++) {
+        coreMap->Release(frames[i]);
+    }
+    delete [] frames;
+    delete usedSlots;
+}
+
+unsigned
+CompressedCache::GetNumFrames() const
+{
+    return numFrames;
+}
+
+char *
+CompressedCache::SlotData(unsigned slot) const
+{
+    ASSERT(slot < numFrames * SLOTS_PER_FRAME);
+
+    unsigned frame = frames[slot / SLOTS_PER_FRAME];
+    return &machine->GetMMU()->mainMemory[frame * PAGE_SIZE
+                                          + slot % SLOTS_PER_FRAME
+                                            * SLOT_SIZE];
+}
+
+void
+CompressedCache::Expand(const Entry *entry, char *page) const
+{
+    ASSERT(entry != nullptr);
+    ASSERT(page != nullptr);
+
+    unsigned char data[MAX_SLOTS * SLOT_SIZE];
+    for (unsigned i = 0; i < entry->numSlots; i++) {
+        memcpy(&data[i * SLOT_SIZE], SlotData(entry->slots[i]), SLOT_SIZE);
+    }
+    Decompress(data, (unsigned char *) page, PAGE_SIZE);
+}
+
+CompressedCache::Entry **
+CompressedCache::Bucket(const AddressSpace *space, unsigned vpn) const
+{
+    uintptr_t key = (uintptr_t) space >> 4 ^ vpn * 2654435761u;
+    return (Entry **) &buckets[key % NUM_BUCKETS];
+}
+
+CompressedCache::Entry *
+CompressedCache::Find(const AddressSpace *space, unsigned vpn) const
+{
+    Entry *e = *Bucket(space, vpn);
+    while (e != nullptr && (e->space != space || e->vpn != vpn)) {
+        e = e->hashNext;
+    }
+    return e;
+}
+
+bool
+CompressedCache::Contains(const AddressSpace *space, unsigned vpn) const
+{
+    return Find(space, vpn) != nullptr;
+}
+
+void
+CompressedCache::Remove(Entry *entry)
+{
+    ASSERT(entry != nullptr);
+
+    Entry **p = Bucket(entry->space, entry->vpn);
+    while (*p != entry) {
+        p = &(*p)->hashNext;
+    }
+    *p = entry->hashNext;
+
+    if (entry->older != nullptr) {
+        entry->older->newer = entry->newer;
+    } else {
+        oldest = entry->newer;
+    }
+    if (entry->newer != nullptr) {
+        entry->newer->older = entry->older;
+    } else {
+        newest = entry->older;
+    }
+
+    for (unsigned i = 0; i < entry->numSlots; i++) {
+        usedSlots->Clear(entry->slots[i]);
+    }
+    delete entry;
+}
+
+void
+CompressedCache::EvictOldest()
+{
+    ASSERT(oldest != nullptr);
+
+    AddressSpace *space = oldest->space;
+    unsigned vpn = oldest->vpn;
+    if (!oldest->dirty) {
+        DEBUG('a', "Compressed page %u dropped from the pool.\n", vpn);
+        Remove(oldest);
+        return;
+    }
+
+    unsigned start = vpn - vpn % SWAP_CLUSTER_PAGES;
+    unsigned first = vpn, last = vpn;
+    Entry *e;
+    while (first > start && (e = Find(space, first - 1)) != nullptr
+           && e->dirty) {
+        first--;
+    }
+    while (last + 1 < start + SWAP_CLUSTER_PAGES
+           && (e = Find(space, last + 1)) != nullptr && e->dirty) {
+        last++;
+    }
+
+    unsigned count = last - first + 1;
+    char *buffer = new char [count * PAGE_SIZE];
+    for (unsigned i = first; i <= last; i++) {
+        e = Find(space, i);
+        Expand(e, &buffer[(i - first) * PAGE_SIZE]);
+        Remove(e);
+    }
+    space->WriteSwapPages(first, count, buffer);
+    delete [] buffer;
+}
+
+bool
+CompressedCache::Store(AddressSpace *space, unsigned vpn, const char *page,
+                       bool dirty)
+{
+    ASSERT(space != nullptr);
+    ASSERT(page != nullptr);
+    ASSERT(!Contains(space, vpn));
+
+    // Anything not saving at least a quarter of the page goes to disk.
+    unsigned char buffer[MAX_SLOTS * SLOT_SIZE];
+    unsigned length = Compress((const unsigned char *) page, PAGE_SIZE,
+                               buffer, MAX_LENGTH);
+    if (length == 0) {
+        stats->numCacheRejects++;
+        return false;
+    }
+
+    unsigned numSlots = (length + SLOT_SIZE - 1) / SLOT_SIZE;
+    while (usedSlots->CountClear() < numSlots) {
+        EvictOldest();
+    }
+
+    Entry *entry = new Entry;
+    entry->space = space;
+    entry->vpn = vpn;
+    entry->dirty = dirty;
+    entry->numSlots = numSlots;
+    for (unsigned i = 0; i < numSlots; i++) {
+        int slot = usedSlots->Find();
+        ASSERT(slot != -1);
+        entry->slots[i] = slot;
+        memcpy(SlotData(slot), &buffer[i * SLOT_SIZE], SLOT_SIZE);
+    }
+
+    Entry **bucket = Bucket(space, vpn);
+    entry->hashNext = *bucket;
+    *bucket = entry;
+    entry->older = newest;
+    entry->newer = nullptr;
+    if (newest != nullptr) {
+        newest->newer = entry;
+    } else {
+        oldest = entry;
+    }
+    newest = entry;
+
+    stats->numCacheStores++;
+    stats->cacheBytesIn += PAGE_SIZE;
+    stats->cacheBytesOut += length;
+    DEBUG('a', "Page %u compressed to %u bytes.\n", vpn, length);
+    return true;
+}
+
+bool
+CompressedCache::Load(AddressSpace *space, unsigned vpn, char *page,
+                      bool *dirty)
+{
+    ASSERT(page != nullptr);
+    ASSERT(dirty != nullptr);
+
+    Entry *entry = Find(space, vpn);
+    if (entry == nullptr) {
+        stats->numCacheMisses++;
+        return false;
+    }
+
+    Expand(entry, page);
+    *dirty = entry->dirty;
+    stats->numCacheHits++;
+    Remove(entry);
+    return true;
+}
+
+void
+CompressedCache::Discard(AddressSpace *space)
+{
+    Entry *e = oldest;
+    while (e != nullptr) {
+        Entry *next = e->newer;
+        if (e->space == space) {
+            if (e->dirty) {
+                // Its process is gone, so it will never be written.
+                stats->numCacheWritesAvoided++;
+            }
+            Remove(e);
+        }
+        e = next;
+    }
+}
@@ -0,0 +1,116 @@
+/// A compressed cache of evicted pages.
+///
+/// Pages evicted from memory are compressed and kept in a pool of frames
+/// taken from the core map, before the swap file.  A fault on a page that is
+/// still in the pool is served without any disk transfer; dirty pages only
+/// reach the swap file when the pool overflows and they are the oldest.
+///
+/// The frames of the pool are split in slots of a fixed size, and the data
+/// of a page takes as many slots as it needs, wherever they are free.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_COMPRESSEDCACHE__HH
+#define NACHOS_VMEM_COMPRESSEDCACHE__HH
+
+
+#include "lib/bitmap.hh"
+#include "machine/mmu.hh"
+
+
+class AddressSpace;
+
+/// Default number of frames given to the pool.
+const unsigned DEFAULT_COMPRESSED_CACHE_FRAMES = 16;
+
+
+class CompressedCache {
+public:
+
+    /// Reserve `numFrames` frames of physical memory for the pool.
+    CompressedCache(unsigned numFrames);
+
+    ~CompressedCache();
+
+    /// Compress the page `vpn` of `space`, whose contents are at `page`, and
+    /// keep it in the pool, making room if needed.
+    ///
+    /// `dirty` tells whether the swap file holds an older copy.  Returns
+    /// false if the page does not compress well enough to be kept, in which
+    /// case the caller has to deal with it.
+    bool Store(AddressSpace *space, unsigned vpn, const char *page,
+               bool dirty);
+
+    /// Take the page `vpn` of `space` out of the pool into `page`.
+    ///
+    /// Returns false if it is not there.  Otherwise, `dirty` tells whether
+    /// the copy in the swap file is stale.
+    bool Load(AddressSpace *space, unsigned vpn, char *page, bool *dirty);
+
+    bool Contains(const AddressSpace *space, unsigned vpn) const;
+
+    /// Drop every page of `space`, which is going away.
+    void Discard(AddressSpace *space);
+
+    /// Frames reserved for the pool.
+    unsigned GetNumFrames() const;
+
+private:
+
+    /// Pages are only kept if they save at least a quarter of their size.
+    static const unsigned MAX_LENGTH = PAGE_SIZE - PAGE_SIZE / 4;
+
+    static const unsigned SLOT_SIZE = PAGE_SIZE / 16;
+    static const unsigned SLOTS_PER_FRAME = PAGE_SIZE / SLOT_SIZE;
+    static const unsigned MAX_SLOTS = (MAX_LENGTH + SLOT_SIZE - 1)
+                                      / SLOT_SIZE;
+
+    class Entry {
+    public:
+        AddressSpace *space;
+        unsigned vpn;
+        bool dirty;
+        unsigned numSlots;
+        unsigned slots[MAX_SLOTS];  ///< Where the data is, in order.
+        Entry *hashNext;  ///< Next entry in the same bucket.
+        Entry *older;     ///< Neighbours in order of arrival.
+        Entry *newer;
+    };
+
+    static const unsigned NUM_BUCKETS = 256;
+
+    /// Address of `slot` in main memory.
+    char *SlotData(unsigned slot) const;
+
+    /// Decompress the page kept in `entry` into `page`.
+    void Expand(const Entry *entry, char *page) const;
+
+    Entry **Bucket(const AddressSpace *space, unsigned vpn) const;
+
+    Entry *Find(const AddressSpace *space, unsigned vpn) const;
+
+    /// Unlink `entry` and free it.
+    void Remove(Entry *entry);
+
+    /// Write the oldest entry to swap if it is dirty, and drop it.  Dirty
+    /// entries next to it in its swap cluster go out in the same transfer.
+    void EvictOldest();
+
+    Entry *buckets[NUM_BUCKETS];
+
+    Entry *oldest;
+    Entry *newest;
+
+    /// Frames reserved for the pool.
+    unsigned numFrames;
+    int *frames;
+
+    /// Slots of the frames holding some data.
+    Bitmap *usedSlots;
+
+};
+
+
+#endif
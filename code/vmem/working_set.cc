@@ -0,0 +1,259 @@
+/// Routines to sample working sets and control admission.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "working_set.hh"
+#include "threads/system.hh"
+
+#include <stdio.h>
+
+
+WorkingSet::WorkingSet(unsigned numPages_)
+{
+    numPages = numPages_;
+    lastReference = new unsigned [numPages];
+    for (unsigned i = 0; i < numPages; i++) {
+        lastReference[i] = 0;
+    }
+    lastSampleTicks = stats->totalTicks;
+    virtualTime = 0;
+    size = 0;
+    pageFaults = 0;
+    intervalFaults = 0;
+    faultFrequency = 0;
+}
+
+WorkingSet::~WorkingSet()
+{
+    delete [] lastReference;
+}
+
+void
+WorkingSet::Grow(unsigned newNumPages)
+{
+    ASSERT(newNumPages >= numPages);
+
+    unsigned *newLastReference = new unsigned [newNumPages];
+    for (unsigned i = 0; i < newNumPages; i++) {
+        newLastReference[i] = i < numPages ? lastReference[i] : 0;
+    }
+    delete [] lastReference;
+    lastReference = newLastReference;
+    numPages = newNumPages;
+}
+
+void
+WorkingSet::Sample(TranslationEntry *pageTable)
+{
+    ASSERT(pageTable != nullptr);
+
+    bool referenced = false;
+    for (unsigned i = 0; i < numPages && !referenced; i++) {
+        referenced = IsReferenced(&pageTable[i]);
+    }
+    if (referenced) {
+        virtualTime++;
+    }
+
+    size = 0;
+    for (unsigned i = 0; i < numPages; i++) {
+        if (IsReferenced(&pageTable[i])) {
+            pageTable[i].use = false;
+            lastReference[i] = virtualTime;
+            coreMap->Touch(pageTable[i].physicalPage);
+        }
+        if (lastReference[i] != 0
+              && virtualTime - lastReference[i] < WORKING_SET_WINDOW) {
+            size++;
+        }
+    }
+
+    faultFrequency = intervalFaults;
+    intervalFaults = 0;
+    lastSampleTicks = stats->totalTicks;
+}
+
+bool
+WorkingSet::IsReferenced(const TranslationEntry *entry) const
+{
+    return entry->valid
+           && (entry->use
+               || coreMap->GetLastUse(entry->physicalPage) > lastSampleTicks);
+}
+
+void
+WorkingSet::AddPageFault()
+{
+    pageFaults++;
+    intervalFaults++;
+}
+
+unsigned
+WorkingSet::GetSize() const
+{
+    return size;
+}
+
+unsigned long
+WorkingSet::GetPageFaults() const
+{
+    return pageFaults;
+}
+
+unsigned
+WorkingSet::GetFaultFrequency() const
+{
+    return faultFrequency;
+}
+
+static void
+SampleHandler(void *arg)
+{
+    ASSERT(arg != nullptr);
+    ((WorkingSetManager *) arg)->Sample();
+}
+
+WorkingSetManager::WorkingSetManager()
+{
+    timer = new Timer(SampleHandler, this, false);
+}
+
+WorkingSetManager::~WorkingSetManager()
+{
+    delete timer;
+}
+
+void
+WorkingSetManager::Sample()
+{
+    for (unsigned i = 0; i < threadsTable->GetCapacity(); i++) {
+        if (!threadsTable->HasKey(i)) {
+            continue;
+        }
+        Thread *t = threadsTable->Get(i);
+        if (t->space != nullptr) {
+            t->space->SampleWorkingSet();
+        }
+    }
+
+    SuspendIfNeeded();
+    ResumeIfPossible();
+}
+
+/// Blocked processes keep their frames, but they cannot make progress if
+/// they are the only ones left running.
+static bool
+IsRunnable(Thread *t)
+{
+    return t->GetStatus() == READY || t->GetStatus() == RUNNING;
+}
+
+/// Frames that processes can page into.  The frames the compressed cache
+/// keeps for itself are among those the core map counts as reserved.
+static unsigned
+AvailableFrames()
+{
+    return coreMap->GetNumFrames() - coreMap->CountReserved();
+}
+
+unsigned
+WorkingSetManager::ActiveSize(unsigned *runnable) const
+{
+    unsigned total = 0;
+    *runnable = 0;
+    for (unsigned i = 0; i < threadsTable->GetCapacity(); i++) {
+        if (!threadsTable->HasKey(i)) {
+            continue;
+        }
+        Thread *t = threadsTable->Get(i);
+        if (t->space != nullptr && !t->IsSuspended()) {
+            total += t->space->GetWorkingSet()->GetSize();
+            if (IsRunnable(t)) {
+                (*runnable)++;
+            }
+        }
+    }
+    return total;
+}
+
+void
+WorkingSetManager::SuspendIfNeeded()
+{
+    unsigned runnable;
+    unsigned total = ActiveSize(&runnable);
+
+    unsigned available = AvailableFrames();
+
+    DEBUG('w', "Working sets of processes not suspended: %u pages, "
+          "%u frames available.\n", total, available);
+
+    // At least one process always runs, however big it is.
+    if (total <= available || runnable <= 1) {
+        return;
+    }
+
+    Thread *victim = nullptr;
+    for (unsigned i = 0; i < threadsTable->GetCapacity(); i++) {
+        if (!threadsTable->HasKey(i)) {
+            continue;
+        }
+        Thread *t = threadsTable->Get(i);
+        if (t->space == nullptr || t->IsSuspended() || !IsRunnable(t)) {
+            continue;
+        }
+        if (victim == nullptr
+              || t->space->GetWorkingSet()->GetSize()
+                 > victim->space->GetWorkingSet()->GetSize()) {
+            victim = t;
+        }
+    }
+    ASSERT(victim != nullptr);
+
+    DEBUG('w', "Working sets need %u frames; suspending %s (%u pages).\n",
+          total, victim->GetName(), victim->space->GetWorkingSet()->GetSize());
+    scheduler->Suspend(victim);
+    stats->numSuspensions++;
+    if (victim == currentThread && interrupt->GetStatus() != IDLE_MODE) {
+        interrupt->YieldOnReturn();
+    }
+}
+
+void
+WorkingSetManager::ResumeIfPossible()
+{
+    unsigned runnable;
+    unsigned total = ActiveSize(&runnable);
+
+    // Suspended processes are resumed in the order they were suspended.
+    Thread *t = scheduler->FirstSuspended();
+    if (t == nullptr) {
+        return;
+    }
+    unsigned size = t->space->GetWorkingSet()->GetSize();
+    if (runnable == 0 || total + size <= AvailableFrames()) {
+        DEBUG('w', "Resuming %s (%u pages).\n", t->GetName(), size);
+        scheduler->Resume(t);
+    }
+}
+
+void
+WorkingSetManager::Print() const
+{
+    printf("\nWorking sets (window of %u samples):\n", WORKING_SET_WINDOW);
+    for (unsigned i = 0; i < threadsTable->GetCapacity(); i++) {
+        if (!threadsTable->HasKey(i)) {
+            continue;
+        }
+        Thread *t = threadsTable->Get(i);
+        if (t->space == nullptr) {
+            continue;
+        }
+        const WorkingSet *ws = t->space->GetWorkingSet();
+        printf("    %s: %u pages, %lu faults, %u faults in last interval%s\n",
+               t->GetName(), ws->GetSize(), ws->GetPageFaults(),
+               ws->GetFaultFrequency(),
+               t->IsSuspended() ? ", suspended" : "");
+    }
+}
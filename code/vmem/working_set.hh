@@ -0,0 +1,123 @@
+/// Working sets of user programs, and admission control based on them.
+///
+/// A timer periodically samples the `use` bits of every address space.  The
+/// working set of a process is estimated as the pages it referenced during
+/// its last `WORKING_SET_WINDOW` samples; samples taken while a process did
+/// not run do not count, so its working set does not shrink just because it
+/// was waiting.  When the working sets of the
+/// running processes do not fit in physical memory together, some of them
+/// are suspended, so that the others do not spend their time faulting pages
+/// in and out; they are resumed when memory pressure drops.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_WORKINGSET__HH
+#define NACHOS_VMEM_WORKINGSET__HH
+
+
+#include "machine/translation_entry.hh"
+
+
+class Thread;
+class Timer;
+
+/// Number of samples a page stays in the working set after being used.
+const unsigned WORKING_SET_WINDOW = 32;
+
+
+/// Working set estimate and page fault counters of an address space.
+class WorkingSet {
+public:
+
+    WorkingSet(unsigned numPages);
+
+    ~WorkingSet();
+
+    /// Make room for pages added to the address space.
+    void Grow(unsigned numPages);
+
+    /// Take a sample of `pageTable`, clearing its `use` bits.
+    ///
+    /// Pages whose `use` bit was cleared by page replacement since the
+    /// previous sample are found through the age kept in the core map.
+    void Sample(TranslationEntry *pageTable);
+
+    void AddPageFault();
+
+    /// Number of pages in the working set, as of the last sample.
+    unsigned GetSize() const;
+
+    /// Number of page faults since the address space was created.
+    unsigned long GetPageFaults() const;
+
+    /// Number of page faults between the last two samples.
+    unsigned GetFaultFrequency() const;
+
+private:
+
+    /// Whether the page of `entry` was used since the previous sample.
+    bool IsReferenced(const TranslationEntry *entry) const;
+
+    unsigned numPages;
+
+    /// Tick of the previous sample.
+    unsigned long lastSampleTicks;
+
+    /// Number of samples in which some page was referenced.
+    unsigned virtualTime;
+
+    /// Value of `virtualTime` when every page was last referenced, or 0.
+    unsigned *lastReference;
+
+    unsigned size;
+
+    unsigned long pageFaults;
+
+    /// Page faults since the last sample.
+    unsigned intervalFaults;
+
+    unsigned faultFrequency;
+
+};
+
+
+/// Samples the working sets and suspends or resumes processes.
+class WorkingSetManager {
+public:
+
+    /// Start the sampling timer.
+    WorkingSetManager();
+
+    ~WorkingSetManager();
+
+    /// Sample every address space and balance the running processes.
+    ///
+    /// Called from the timer interrupt handler.
+    void Sample();
+
+    /// Print the working set and page fault frequency of every process.
+    void Print() const;
+
+private:
+
+    /// Suspend the runnable process with the largest working set, if the
+    /// processes that are not suspended need more frames than there are.
+    void SuspendIfNeeded();
+
+    /// Resume a suspended process, if its working set fits in memory or
+    /// nobody else can run.
+    void ResumeIfPossible();
+
+    /// Sum of the working sets of the processes that are not suspended.
+    ///
+    /// `runnable` is set to how many of them are ready or running.
+    unsigned ActiveSize(unsigned *runnable) const;
+
+    Timer *timer;
+
+};
+
+
+#endif